@@ -0,0 +1,66 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace inc {
+
+// Times the soft body step on a matrix of soft spheres for 1, 2, 4... 
+// threads, up to the hardware thread count. The spheres are made in the live
+// world but not added to the scene, and are removed when each run is done, 
+// so run it on an empty scene for clean numbers.
+//
+// run_collision_modes() times the same matrix once per soft collision mode
+// (see SoftCollider) on the current thread count instead.
+class SoftBodyBenchmark {
+public:
+    SoftBodyBenchmark();
+
+    void run();
+    void run_collision_modes();
+
+    // thread count, steps per second
+    const std::vector<std::pair<int, float> >& results() { return results_; }
+    // ie "1: 8.2  2: 15.1  4: 26.7"
+    std::string summary();
+    // SoftCollider::Mode, steps per second
+    const std::vector<std::pair<int, float> >& collision_results() { 
+        return collision_results_; 
+    }
+    // ie "vertex-face: 8.2  clusters: 30.4  hashed: 21.7"
+    std::string collision_summary();
+
+    int width_;
+    int height_;
+    int depth_;
+    float radius_;
+    int steps_;
+
+private:
+    float time_steps(int num_threads);
+
+    std::vector<std::pair<int, float> > results_;
+    std::vector<std::pair<int, float> > collision_results_;
+};
+
+}
@@ -0,0 +1,79 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <map>
+
+#include <btBulletDynamicsCommon.h>
+
+namespace inc {
+
+// Hands out shared collision shapes for rigid primitives. Shapes are keyed
+// by primitive type and dimensions and reference counted, so a matrix of a
+// thousand equal spheres uses one btSphereShape (see BasicDemo.cpp). The 
+// local inertia is worked out once per shape, for unit mass.
+class CollisionShapeCache {
+public:
+    CollisionShapeCache();
+    ~CollisionShapeCache();
+
+    btCollisionShape* acquire_sphere(float radius);
+    btCollisionShape* acquire_box(const btVector3& half_extents);
+
+    // returns false if the shape didn't come from the cache, in which case
+    // the caller still owns it. cached shapes are deleted when the last
+    // body using them releases them
+    bool release(btCollisionShape*);
+
+    // primitive inertia scales linearly with mass
+    btVector3 local_inertia(btCollisionShape*, float mass);
+
+    int num_shapes() { return (int) shapes_.size(); }
+    int num_references() { return total_references_; }
+
+private:
+    enum ShapeType {
+        SPHERE = 0,
+        BOX
+    };
+
+    struct Key {
+        int type;
+        float dimensions[3];
+
+        bool operator<(const Key& k) const;
+    };
+
+    struct Entry {
+        btCollisionShape* shape;
+        float unit_inertia[3];
+        int references;
+    };
+
+    btCollisionShape* acquire(const Key&);
+    btCollisionShape* create_shape(const Key&);
+
+    std::map<Key, Entry> shapes_;
+    std::map<btCollisionShape*, Key> keys_;
+
+    int total_references_;
+};
+
+}
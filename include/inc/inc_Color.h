@@ -107,11 +107,17 @@ public:
     }
 
     static void set_color_mode(ColorMode mode);
+    static ColorMode color_mode() { return mode_; }
     static void set_color(float r, float g, float b);
     static void set_color(const ci::Color& c);
     static void set_color_a(float r, float g, float b, float a);
     static void set_color_a(const ci::ColorA& c);
 
+    // around drawing from a color array: when lighting, the array stands in
+    // for the material set_color_a would set
+    static void begin_vertex_colors();
+    static void end_vertex_colors();
+
 private:
     static ColorMode mode_;
     static std::shared_ptr<ColorInterface> color_interface_;
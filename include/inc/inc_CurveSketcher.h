@@ -32,6 +32,7 @@
 #include <cinder/Color.h>
 
 #include <inc/inc_Module.h>
+#include <inc/inc_SplineSampler.h>
 
 namespace inc {
 
@@ -88,6 +89,12 @@ private:
 
     // the spline is defined between 0 and 1
     float rendering_resolution_;
+    std::vector<float> rendering_params_;
+    std::vector<float> center_params_;
+    // the spline only changes when a control point moves, so the samples
+    // are kept between frames
+    SplineSampler rendering_sampler_;
+    SplineSampler center_sampler_;
     float line_thickness_;
     ci::ColorA line_color_;
 
@@ -88,4 +88,38 @@ private:
     float INC_EPSILON;
 };
 
+// Writes Wavefront OBJ. Soft bodies and TriMeshes keep their shared 
+// vertices, so the saved mesh is welded, everything else is written as 
+// loose triangles and lines. Each layer is an OBJ group.
+class ObjSaver : public Exporter {
+public:
+    ObjSaver(const std::string& file_name);
+
+    void set_path(const std::string&);
+
+    virtual void input_soft_solid(SoftSolid& solid);
+
+    void begin();
+    void end();
+
+    void set_layer(int);
+    void add_layer();
+
+    virtual void write_line(const ci::Vec3f& v1, const ci::Vec3f& v2);
+    virtual void write_triangle(const ci::Vec3f& v1,
+        const ci::Vec3f& v2, const ci::Vec3f& v3);
+    virtual void write_trimesh(const ci::TriMesh& mesh);
+    virtual void write_trimesh_wireframe(const ci::TriMesh& mesh);
+
+private:
+    void write_vertex(float x, float y, float z);
+    void write_group();
+
+    std::ofstream file_;
+    std::string file_name_;
+
+    int num_vertices_; // OBJ indices are 1 based and global to the file
+    int current_layer_;
+};
+
 }
\ No newline at end of file
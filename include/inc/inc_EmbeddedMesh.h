@@ -0,0 +1,110 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <BulletSoftBody/btSoftBody.h>
+
+#include <cinder/TriMesh.h>
+#include <cinder/Vector.h>
+
+namespace inc {
+class TaskPool;
+
+// A full resolution mesh carried along by a coarse soft body, the cage. 
+// Only the cage is simulated; every fine vertex is bound to the cage face
+// nearest to it at rest, by the barycentric coordinates of its projection
+// onto the face plus its height above it, and is rebuilt from the three
+// nodes whenever update() is called.
+class EmbeddedMesh {
+public:
+    // fine is welded, and in the cage's space before scale was applied.
+    // fine_to_cage is the cage vertex each fine vertex was clustered into
+    // (see decimate()), used to narrow the search; it can be empty
+    EmbeddedMesh(const ci::TriMesh& fine, const std::vector<int>& fine_to_cage,
+        btSoftBody* cage, ci::Vec3f scl);
+
+    // moves the fine vertices to follow the cage nodes. If previous is given
+    // the nodes are taken between previous and the current positions, like
+    // the interpolated drawing. Split across the pool's threads if there is
+    // one
+    void update(TaskPool* = NULL, 
+        const btAlignedObjectArray<btVector3>* previous = NULL, 
+        float alpha = 1.0f);
+    // the same, with the cage node positions given rather than read from the
+    // cage, for drawing from a copy published by the physics thread
+    void update(TaskPool*, const btVector3* nodes);
+
+    int num_vertices() { return (int) bindings_.size(); }
+    int num_triangles() { return (int) indices_.size() / 3; }
+    // as of the last update
+    const btAlignedObjectArray<btVector3>& positions() { return positions_; }
+    const btAlignedObjectArray<btVector3>& normals() { return normals_; }
+    const std::vector<int>& indices() { return indices_; }
+
+    // grows bounds taken around the cage nodes by as far as the fine 
+    // vertices reached past them at the last update, since a vertex can be
+    // bound outside its face and above it
+    void expand_cage_bounds(btVector3& min, btVector3& max);
+
+    // vertex clustering: vertices within cell_size of each other are merged,
+    // collapsed and repeated triangles are dropped and unused vertices
+    // removed. fine_to_cage gets the cage vertex of every mesh vertex, -1 if
+    // its cluster was dropped
+    static std::tr1::shared_ptr<ci::TriMesh> decimate(const ci::TriMesh&, 
+        float cell_size, std::vector<int>& fine_to_cage);
+
+private:
+    struct Binding {
+        int node[3];
+        btScalar weight[3]; // barycentric, can be outside 0..1 
+        btScalar offset; // along the face normal
+    };
+
+    void bind(int vertex, const btVector3& p, const std::vector<int>& faces);
+    // rebuilds positions_ and normals_ from nodes_
+    void deform(TaskPool*);
+    // outset_min_ and outset_max_ from the new positions
+    void update_outsets();
+    void update_normals(TaskPool*);
+
+    btSoftBody* cage_;
+
+    std::vector<Binding> bindings_;
+    std::vector<int> indices_;
+
+    // the faces around each vertex, vertex i's are 
+    // vertex_faces_[vertex_face_start_[i] .. vertex_face_start_[i + 1])
+    std::vector<int> vertex_face_start_;
+    std::vector<int> vertex_faces_;
+
+    btAlignedObjectArray<btVector3> nodes_; // the cage node positions used
+    btAlignedObjectArray<btVector3> positions_;
+    btAlignedObjectArray<btVector3> face_normals_;
+    btAlignedObjectArray<btVector3> normals_;
+
+    // how far the fine vertices reached past the nodes' bounds on each side,
+    // as of the last update, never negative
+    btVector3 outset_min_;
+    btVector3 outset_max_;
+};
+
+}
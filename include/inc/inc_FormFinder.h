@@ -0,0 +1,69 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include <cinder/TriMesh.h>
+
+namespace inc {
+
+class SoftSolid;
+class Exporter;
+
+// Steps the world with no window or rendering until a soft mesh settles,
+// then saves it. Convergence is SolidFactory's settle test (the kinetic 
+// energy staying under settle_energy_ for settle_time_), measured in 
+// simulated seconds rather than wall clock. The mesh has to be in the 
+// Manager's solid list, the settle check only looks there.
+class FormFinder {
+public:
+    FormFinder();
+
+    // returns true if the mesh settled before max_steps_
+    bool run(std::shared_ptr<SoftSolid> solid);
+
+    // file names ending in .obj are written as OBJ, anything else as DXF
+    static void save(std::shared_ptr<SoftSolid> solid, 
+        const std::string& file_name);
+    static void save(const ci::TriMesh& mesh, const std::string& file_name);
+
+    int steps() { return steps_; }
+    double seconds() { return seconds_; }
+    bool converged() { return converged_; }
+    float steps_per_second();
+    // ie "settled after 1520 steps, 3.21 s, 473 steps/sec"
+    std::string summary();
+
+    float time_step_; // simulated seconds per step
+    int max_steps_;
+
+private:
+    // opens the exporter the file name asks for and runs write on it
+    static void save(const std::string& file_name, 
+        const std::function<void (Exporter&)>& write);
+
+    int steps_;
+    double seconds_;
+    bool converged_;
+};
+
+}
@@ -0,0 +1,48 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cinder/Camera.h>
+#include <cinder/AxisAlignedBox.h>
+#include <cinder/Matrix.h>
+#include <cinder/Vector.h>
+
+namespace inc {
+
+// The six planes bounding what a camera can see, in world space, for 
+// skipping things that are entirely off screen. The test is conservative:
+// a box near a corner of the frustum can pass without being visible, but a
+// visible box never fails.
+class Frustum {
+public:
+    Frustum();
+
+    void set(const ci::Camera&);
+    // the planes of projection * modelview
+    void set(const ci::Matrix44f& projection, const ci::Matrix44f& modelview);
+
+    // false only if the box is wholly outside one of the planes
+    bool intersects(const ci::AxisAlignedBox3f&) const;
+
+private:
+    // (a, b, c, d) with a x + b y + c z + d >= 0 on the inside
+    ci::Vec4f planes_[6];
+};
+
+}
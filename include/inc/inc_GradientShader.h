@@ -0,0 +1,52 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cinder/gl/gl.h>
+#include <cinder/gl/GlslProg.h>
+#include <cinder/Color.h>
+
+namespace inc {
+
+// Colors whatever is drawn while it's bound by height, from base at min_y
+// to top at max_y, in place of its vertex colors. When Color is in 
+// LIGHTING mode the result is lit by GL_LIGHT0 the way the fixed function
+// pipeline would light a GL_AMBIENT_AND_DIFFUSE material of that color.
+// Heights are in the coordinates the vertices are given in, which for soft
+// bodies is world space.
+class GradientShader {
+public:
+    GradientShader();
+
+    // compiles the program, which needs a context. Returns false, leaving
+    // available() false, if the card or driver can't run it
+    bool setup();
+    bool available() { return available_; }
+
+    void bind(float min_y, float max_y, const ci::ColorA& base, 
+        const ci::ColorA& top);
+    void unbind();
+
+private:
+    ci::gl::GlslProg program_;
+    bool available_;
+};
+
+}
@@ -27,9 +27,14 @@
 #include <cinder/Vector.h>
 #include <cinder/gl/Vbo.h>
 #include <cinder/Ray.h>
+#include <cinder/AxisAlignedBox.h>
+
+#include <inc/inc_MeshBuffer.h>
+#include <inc/inc_GridShader.h>
 
 namespace inc {
 class Exporter;
+class EmbeddedMesh;
 
 class GraphicItem {
 public:
@@ -43,6 +48,10 @@ public:
     void set_visible(bool);
     bool visible();
 
+    // a world space box around what draw() draws, for culling. Items 
+    // without one are always drawn
+    virtual bool bounds(ci::AxisAlignedBox3f&) { return false; }
+
 private:
     bool visible_;
 };
@@ -78,15 +87,31 @@ public:
 
     virtual void draw();
 
+    // menu hooks, the lines are rebuilt on the next draw
+    bool adjust_grid(float);
     float* grid_plane_size_ptr();
     float* grid_plane_intervals_ptr();
+    // draws the grid with GridShader out to the far clip, at the same 
+    // spacing, if the card can run it
+    bool* infinite_grid_ptr() { return &infinite_grid_; }
 
 private:
+    // the axes then the grid lines, into lines_
+    void build_lines();
     void draw_axis();
     void draw_grid_plane_lines();
+    void draw_infinite_grid();
 
     float grid_plane_size_;
     float grid_plane_intervals_;
+    bool infinite_grid_;
+
+    bool initialized_;
+    ci::gl::Vbo lines_;
+    bool lines_valid_;
+    int num_grid_vertices_;
+
+    GridShader grid_shader_;
 };
 
 
@@ -157,57 +182,117 @@ public:
     static ci::ColorA face_normals_color_;
 
 private:
+    // writes this frame's nodes, or the embedded mesh's vertices, into 
+    // mesh_buffer_, and finds their heights for the gradient
+    void fill_mesh_buffer();
+    void fill_embedded_mesh_buffer(EmbeddedMesh&);
+    // through the Renderer's GradientShader if there is one, otherwise with
+    // the colors from the fill
+    void draw_triangles();
+    // each edge once, from mesh_buffer_
+    void draw_edges();
+    void draw_face_normals();
+    // the same, for a body that is only the cage of a finer mesh
+    void draw_embedded_face_normals(EmbeddedMesh&);
+    ci::ColorA height_color(float y, const ci::ColorA& base, 
+        const ci::ColorA& top);
+
+    // everything a settled body's buffer and display list depend on 
+    // besides the nodes
+    struct FrozenState {
+        ci::ColorA base_color;
+        ci::ColorA top_color;
+        bool flip_normals;
+        bool draw_face_normals;
+        int color_mode;
+
+        bool operator==(const FrozenState&) const;
+    };
+
+    FrozenState current_frozen_state();
+
+    // points render_positions_ and render_normals_ at the body's nodes in 
+    // the physics thread's latest state, if the thread is running. Returns 
+    // false if the body should be skipped, when it hasn't been published yet
+    bool bind_render_state();
+
+    // the triangles and edges. A settled body doesn't move, so it isn't 
+    // refilled while it's settled
+    MeshBuffer mesh_buffer_;
+
+    // the face normals are drawn from this while the body is settled
+    GLuint display_list_;
+    bool display_list_valid_;
+    FrozenState frozen_state_;
+
     ci::Vec3f get_face_center(int index) {
-        return ci::Vec3f(
-            (soft_body_->m_faces[index].m_n[0]->m_x.x() + 
-            soft_body_->m_faces[index].m_n[1]->m_x.x() + 
-            soft_body_->m_faces[index].m_n[2]->m_x.x()) / 3.0f,
-
-            (soft_body_->m_faces[index].m_n[0]->m_x.y() + 
-            soft_body_->m_faces[index].m_n[1]->m_x.y() + 
-            soft_body_->m_faces[index].m_n[2]->m_x.y()) / 3.0f,
-
-            (soft_body_->m_faces[index].m_n[0]->m_x.z() + 
-            soft_body_->m_faces[index].m_n[1]->m_x.z() + 
-            soft_body_->m_faces[index].m_n[2]->m_x.z()) / 3.0f);
+        btVector3 center = (node_position(index, 0) + node_position(index, 1) +
+            node_position(index, 2)) / 3.0f;
+
+        return ci::Vec3f(center.x(), center.y(), center.z());
+    }
+
+    int node_index(int face, int node) {
+        return int(soft_body_->m_faces[face].m_n[node] - &soft_body_->m_nodes[0]);
+    }
+
+    btVector3 face_normal(int face) {
+        if (render_positions_ == NULL)
+            return soft_body_->m_faces[face].m_normal;
+
+        btVector3 a = node_position(face, 0);
+
+        return (node_position(face, 1) - a).cross(
+            node_position(face, 2) - a).normalized();
     }
 
-    void make_gl_normal(int face, int node) {
-        if (flip_normals_) {
-            glNormal3f(
-                -soft_body_->m_faces[face].m_n[node]->m_n.x(),
-                -soft_body_->m_faces[face].m_n[node]->m_n.y(),
-                -soft_body_->m_faces[face].m_n[node]->m_n.z());
-        } else { 
-            glNormal3f(
-                soft_body_->m_faces[face].m_n[node]->m_n.x(),
-                soft_body_->m_faces[face].m_n[node]->m_n.y(),
-                soft_body_->m_faces[face].m_n[node]->m_n.z());
-        }
+    // the position node i is drawn at, which is between the last two
+    // physics steps when the fixed timestep is interpolating, or the last
+    // published one when physics is on its own thread
+    btVector3 position(int i) {
+        if (render_positions_ != NULL)
+            return render_positions_[i];
+
+        const btVector3& x = soft_body_->m_nodes[i].m_x;
+
+        if (previous_positions_ == NULL)
+            return x;
+
+        return (*previous_positions_)[i].lerp(x, interpolation_alpha_);
     }
 
-    void make_gl_vertex(int face, int node) {
-        glVertex3f(
-            soft_body_->m_faces[face].m_n[node]->m_x.x(),
-            soft_body_->m_faces[face].m_n[node]->m_x.y(),
-            soft_body_->m_faces[face].m_n[node]->m_x.z());
+    const btVector3& normal(int i) {
+        return render_normals_ != NULL ? render_normals_[i] : 
+            soft_body_->m_nodes[i].m_n;
+    }
+
+    btVector3 node_position(int face, int node) {
+        return position(node_index(face, node));
     }
 
     btSoftBody* soft_body_;
     ci::ColorA color_;
 
     float get_vertex_height(int face, int node) { 
-        return soft_body_->m_faces[face].m_n[node]->m_x.y(); 
+        return node_position(face, node).y(); 
     }
 
+    // set at the start of each draw from the SoftSolid
+    const btAlignedObjectArray<btVector3>* previous_positions_;
+    float interpolation_alpha_;
+    // set by bind_render_state, NULL when physics runs on the main thread
+    const btVector3* render_positions_;
+    const btVector3* render_normals_;
+
+    // as of the last fill
     float last_min_y_;
     float last_max_y_;
 };
 
 class Exporter;
 
-// TODO: create smooth mesh, with per vertex normals
-
+// A mesh that doesn't move, like the context models. It is uploaded once
+// and drawn with one call.
 class ShadedMesh : public GraphicItem {
 public:
     ShadedMesh(const ci::TriMesh& mesh);
@@ -218,6 +303,9 @@ public:
 
     void draw();
 
+    // Override
+    virtual bool bounds(ci::AxisAlignedBox3f&);
+
     void set_color(const ci::ColorA& c);
 
     void set_shade(bool s) { shade_ = s; }
@@ -230,18 +318,20 @@ public:
 private:
     void init();
     void build_normals();
+    void fill_buffer();
 
     ci::TriMesh mesh_;
-    std::vector<ci::Vec3f> normals_;
+    std::vector<ci::Vec3f> normals_; // one per vertex
+    ci::AxisAlignedBox3f bounds_; // the mesh never moves
+
+    MeshBuffer buffer_;
+    bool buffer_valid_;
 
     ci::ColorA color_;
 
     bool shade_;
     bool draw_wireframe_;
     bool save_;
-
-    ci::Vec3f a_, b_, c_;
-
 };
 
 }
\ No newline at end of file
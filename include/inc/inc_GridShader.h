@@ -0,0 +1,50 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cinder/gl/gl.h>
+#include <cinder/gl/GlslProg.h>
+#include <cinder/Color.h>
+#include <cinder/Vector.h>
+
+namespace inc {
+
+// Draws the lines of a grid on the y = 0 plane, spacing apart, over a 
+// square that follows the eye, so it reaches to the horizon whatever its
+// density. The lines are found per pixel from the plane coordinates and
+// keep the same width on screen, and fade out towards fade_distance.
+class GridShader {
+public:
+    GridShader();
+
+    // compiles the program, which needs a context. Returns false, leaving
+    // available() false, if the card or driver can't run it
+    bool setup();
+    bool available() { return available_; }
+
+    void draw(const ci::Vec3f& eye, float spacing, float fade_distance, 
+        const ci::ColorA&);
+
+private:
+    ci::gl::GlslProg program_;
+    bool available_;
+};
+
+}
@@ -115,6 +115,8 @@ public:
     bool create_rigid_sphere_matrix(bool);
     bool create_rigid_sphere_spring_matrix(bool);
     bool create_soft_cylinder(bool);
+    bool run_benchmark(bool);
+    bool run_collision_benchmark(bool);
 
     // Override
     std::string name() { return "SOLIDS"; }
@@ -130,6 +132,9 @@ private:
     int matrix_d_;
 
     float sphere_radius_;
+
+    std::string benchmark_results_;
+    std::string collision_benchmark_results_;
 };
 
 class Solid;
@@ -213,16 +218,21 @@ public:
     bool save_image(bool);
     bool save_high_res(bool);
     bool save_dxf(bool); // called by a button so its passed a bool
+    // saves each replayed step, see SolidFactory::adjust_replaying
+    bool save_replay(bool);
 
     std::string name() { return "FILE"; }
 
 private:
     std::string get_uuid();
     std::string get_file_name();
+    void write_dxf(const std::string& file_name);
 
     int image_counter_;
     int high_res_image_width_;
     bool save_uuid_; // use a uuid instead of a number
+    int replay_stride_; // save every nth step
+    bool replay_dxf_;
 
     std::string file_name_;
 };
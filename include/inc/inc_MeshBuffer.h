@@ -0,0 +1,130 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include <LinearMath/btVector3.h>
+
+#include <cinder/gl/gl.h>
+#include <cinder/gl/Vbo.h>
+#include <cinder/Color.h>
+#include <cinder/Vector.h>
+
+namespace inc {
+
+// A mesh whose vertices move every frame, drawn from buffers on the card.
+// The triangles are uploaded once as indices into the vertices, so a 
+// vertex shared by several faces is only sent once. The vertices are 
+// written again each frame into storage that is orphaned first, so the 
+// driver hands back fresh memory instead of waiting on the last frame's
+// draw. One draw call per mesh, and one for its wireframe, which draws
+// each edge once however many triangles share it.
+class MeshBuffer {
+public:
+    struct Vertex {
+        GLfloat position[3];
+        GLfloat normal[3];
+        GLubyte color[4];
+
+        void set(const btVector3& p, const btVector3& n, const ci::ColorA& c);
+        void set(const ci::Vec3f& p, const ci::Vec3f& n, const ci::ColorA& c);
+        // leaves the color alone, for drawing through a shader that 
+        // doesn't use it
+        void set(const btVector3& p, const btVector3& n);
+    };
+
+    // GL_STATIC_DRAW for a mesh that's only filled once in a while
+    MeshBuffer(GLenum usage = GL_STREAM_DRAW);
+
+    // three vertex indices per triangle. The unique edges are found and
+    // uploaded with them
+    void set_triangles(const std::vector<GLuint>&);
+    int num_triangle_indices() { return num_triangle_indices_; }
+    int num_edge_indices() { return num_edge_indices_; }
+
+    // returns room for num_vertices, to be filled in before unmap(), or 
+    // NULL, with nothing to unmap, if there are none. When the driver can't
+    // map the buffer this is a copy that unmap() uploads
+    Vertex* map(int num_vertices);
+    void unmap();
+    int num_vertices() { return num_vertices_; }
+
+    // the colors stand in for the material when lighting
+    void draw_triangles();
+    // in the current color
+    void draw_edges();
+
+    // every edge of the triangles once, as pairs of vertex indices
+    template <typename Index>
+    static void find_edges(const std::vector<Index>& triangles, 
+        std::vector<GLuint>& edges);
+
+private:
+    void init();
+    // binds the vertices and points the vertex array, and the normal and
+    // color arrays if attributes is set, at them. Pushes the client state,
+    // unbind_vertices() pops it
+    void bind_vertices(bool attributes);
+    void unbind_vertices();
+
+    bool initialized_;
+    GLenum usage_;
+    ci::gl::Vbo vertices_;
+    ci::gl::Vbo triangles_;
+    ci::gl::Vbo edges_;
+    int num_vertices_;
+    int num_triangle_indices_;
+    int num_edge_indices_;
+
+    std::vector<Vertex> staging_; // when the buffer can't be mapped
+    bool staged_;
+};
+
+template <typename Index>
+void MeshBuffer::find_edges(const std::vector<Index>& triangles, 
+    std::vector<GLuint>& edges) {
+    std::vector<std::pair<GLuint, GLuint> > pairs;
+    pairs.reserve(triangles.size());
+
+    for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+        for (int j = 0; j < 3; ++j) {
+            GLuint a = (GLuint) triangles[i + j];
+            GLuint b = (GLuint) triangles[i + (j + 1) % 3];
+
+            pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    edges.clear();
+    edges.reserve(pairs.size() * 2);
+
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        edges.push_back(pairs[i].first);
+        edges.push_back(pairs[i].second);
+    }
+}
+
+}
@@ -24,6 +24,8 @@
 #include <cinder/TriMesh.h>
 #include <cinder/Vector.h>
 
+#include <inc/inc_SplineSampler.h>
+
 namespace inc {
 
 class Solid;
@@ -119,6 +121,10 @@ private:
 
     std::tr1::shared_ptr<MeshNetwork> mesh_network_;
 
+    // keeps the last bspline sampling, so rebuilding from the same curve
+    // doesn't evaluate it again
+    SplineSampler spline_sampler_;
+
     float mesh_scale_;
     int arch_resolution_;
     int slice_resolution_;
@@ -0,0 +1,96 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include <cinder/TriMesh.h>
+#include <cinder/Vector.h>
+
+namespace inc {
+
+// Merges vertices that share a position. Vertices are bucketed in a hash 
+// grid, so each new one is only compared with the few already in its own
+// and the neighbouring cells, rather than with every vertex so far.
+//
+// With a tolerance of 0 only exact float matches are merged (-0 and 0 
+// count as the same). Otherwise a vertex is merged into the closest 
+// existing one within the tolerance, if there is one.
+class MeshWelder {
+public:
+    explicit MeshWelder(float tolerance = 0.0f);
+
+    // returns the welded index of the position, adding it if it's new
+    int add(const ci::Vec3f&);
+
+    // welds every vertex of the mesh, then writes three welded indices per
+    // triangle to triangles. Each vertex and index is read once, and 
+    // triangles that collapse are dropped
+    void weld(const ci::TriMesh&, std::vector<int>& triangles);
+
+    // tightly packed xyz, so it can go straight to Bullet as a btScalar*
+    const std::vector<ci::Vec3f>& vertices() { return vertices_; }
+    // the height range of the welded vertices, 0 if there are none
+    float min_y() { return min_y_; }
+    float max_y() { return max_y_; }
+    void reserve(size_t num_vertices);
+    void clear();
+
+    // triangles that collapse to a line or point are dropped
+    static std::tr1::shared_ptr<ci::TriMesh> weld(const ci::TriMesh&,
+        float tolerance = 0.0f);
+
+private:
+    struct Cell {
+        int x;
+        int y;
+        int z;
+
+        bool operator==(const Cell& c) const { 
+            return x == c.x && y == c.y && z == c.z; 
+        }
+    };
+
+    struct CellHash {
+        size_t operator()(const Cell& c) const {
+            // the usual large primes, see Teschner et al. 2003
+            return (size_t) (((unsigned int) c.x * 73856093u) ^ 
+                ((unsigned int) c.y * 19349663u) ^ 
+                ((unsigned int) c.z * 83492791u));
+        }
+    };
+
+    typedef std::tr1::unordered_multimap<Cell, int, CellHash> CellMap;
+
+    Cell cell(const ci::Vec3f&);
+    int find_exact(const ci::Vec3f&, const Cell&);
+    int find_nearest(const ci::Vec3f&, const Cell&);
+
+    float tolerance_;
+    std::vector<ci::Vec3f> vertices_;
+    CellMap cells_;
+    std::vector<int> remap_; // welded index of each vertex of the input
+
+    float min_y_;
+    float max_y_;
+};
+
+}
@@ -37,6 +37,7 @@ public:
     void draw();
 
     bool* draw_grid_ptr() { return &draw_grid_; }
+    OriginGraphicItem& graphic_item() { return *origin_graphic_item_; }
 
     static Origin& instance() { return *instance_; }
 
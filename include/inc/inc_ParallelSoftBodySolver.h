@@ -0,0 +1,94 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <BulletSoftBody/btSoftBody.h>
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
+
+#include <inc/inc_SoftCollider.h>
+
+namespace inc {
+
+class TaskPool;
+
+// Runs the per body parts of the soft body step on a TaskPool. Bodies that
+// can push on each other during the solve (through soft contacts, joints, or
+// a shared dynamic rigid body) are grouped into islands, and each island is
+// solved on one thread, so the result matches the single threaded solver.
+// Collision detection and the cluster solve stay on the calling thread.
+// Soft against soft collision goes through collider(), see SoftCollider.
+class ParallelSoftBodySolver : public btDefaultSoftBodySolver {
+public:
+    ParallelSoftBodySolver(TaskPool&);
+    virtual ~ParallelSoftBodySolver();
+
+    // Override
+    virtual void predictMotion(float solverdt);
+    // Override
+    virtual void solveConstraints(float solverdt);
+    using btDefaultSoftBodySolver::processCollision;
+    // Override
+    virtual void processCollision(btSoftBody*, btSoftBody*);
+
+    SoftCollider& collider() { return collider_; }
+
+    // when disabled this is the stock btDefaultSoftBodySolver
+    void set_enabled(bool e) { enabled_ = e; }
+    bool enabled() { return enabled_; }
+
+    // islands always go to the same threads in the same order
+    void set_deterministic(bool d) { deterministic_ = d; }
+    bool deterministic() { return deterministic_; }
+
+    int num_islands() { return (int) islands_.size(); }
+
+private:
+    bool use_threads();
+    void build_islands();
+    int find_root(int);
+    void join(int, int);
+    int rigid_id(const btCollisionObject*);
+    int node_owner(const btSoftBody::Node*);
+
+    TaskPool& pool_;
+    SoftCollider collider_;
+
+    bool enabled_;
+    bool deterministic_;
+
+    std::vector<btSoftBody*> active_;
+    std::vector<btBroadphaseProxy*> proxies_;
+
+    std::vector<btSoftBody*> bodies_;
+
+    // union find over the soft bodies, followed by the dynamic rigid bodies
+    // they touch
+    std::vector<int> parents_;
+    std::map<const btCollisionObject*, int> rigid_ids_;
+    // first node of each body, sorted, for finding a node's owner
+    std::vector<std::pair<const btSoftBody::Node*, int> > node_ranges_;
+
+    std::vector<std::vector<btSoftBody*> > islands_;
+};
+
+}
@@ -0,0 +1,162 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <boost/thread/mutex.hpp>
+
+#include <btBulletDynamicsCommon.h>
+
+#include <cinder/Timer.h>
+
+namespace inc {
+
+// Where a physics frame goes. Our own Scope timers around the parts of 
+// SolidFactory::update, everything Bullet's built in profiler 
+// (CProfileManager) recorded inside the step, and the size and collision
+// load of every body, so the cost can be put down to individual soft 
+// bodies. Shown in the display menu and optionally logged every frame to
+// CSV, or to JSON with one frame object per line.
+//
+// Nothing is measured while it's switched off. When the physics thread is
+// running a frame is one step on that thread, and the menu shows the last
+// one finished. Bullet has to be built without BT_NO_PROFILE for its
+// sections to show up, and its profiler isn't thread safe, so they're only
+// right with the parallel soft body solver off.
+class PhysicsProfiler {
+public:
+    enum LogFormat {
+        CSV = 0,
+        JSON
+    };
+
+    struct Section {
+        std::string name; // Bullet's are paths, ie "stepSimulation/..."
+        double ms;
+        double self_ms; // less the sections inside it
+        int calls;
+        bool bullet;
+    };
+
+    // one per collision object, in the world's order. The counts are -1 
+    // for a rigid or static body
+    struct Body {
+        int index;
+        int nodes;
+        int links;
+        int faces;
+        int clusters;
+        int contacts; // manifold points, or soft body contacts
+        int pairs; // broadphase pairs it's in
+    };
+
+    struct Frame {
+        Frame();
+
+        int number;
+        double ms;
+        std::vector<Section> sections;
+        std::vector<Body> bodies;
+    };
+
+    // times the enclosing block into the section name of the current frame
+    class Scope {
+    public:
+        Scope(PhysicsProfiler&, const char* name);
+        ~Scope();
+
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+        PhysicsProfiler* profiler_;
+        const char* name_;
+        double start_;
+    };
+
+    PhysicsProfiler();
+
+    // on whichever thread steps the world
+    void begin_frame();
+    void end_frame(btCollisionWorld*);
+
+    // copies the last finished frame into the menu readouts, and the menu
+    // settings out to the stepping thread, main thread
+    void update_readout();
+
+    // menu hooks
+    bool* enabled_ptr() { return &enabled_; }
+    bool* log_ptr() { return &log_; }
+    int* log_format_ptr() { return &log_format_; }
+    std::string* log_name_ptr() { return &log_name_; }
+    // read only
+    float* frame_ms_ptr() { return &frame_ms_; }
+    std::string* sections_ptr() { return &sections_; }
+    std::string* bullet_sections_ptr() { return &bullet_sections_; }
+    std::string* largest_soft_body_ptr() { return &largest_soft_body_; }
+
+private:
+    // what the menu hooks write, copied for the stepping thread
+    struct Settings {
+        bool enabled;
+        bool log;
+        int log_format;
+        std::string log_name;
+    };
+
+    void add_time(const char* name, double ms);
+    void read_bullet_profile(Frame&);
+    void read_bodies(btCollisionWorld*, Frame&);
+    void write_log(const Frame&);
+
+    bool enabled_;
+    bool log_;
+    int log_format_;
+    std::string log_name_;
+
+    // the stepping thread's copy, taken at begin_frame
+    Settings settings_;
+
+    ci::Timer clock_;
+    bool in_frame_; // settings_.enabled as of begin_frame
+    double frame_start_;
+    Frame frame_;
+
+    // the last finished frame, written by the stepping thread, and the 
+    // settings as of the last update_readout. log_failed_ is set when the
+    // log couldn't be opened, so the menu switch goes off
+    boost::mutex mutex_;
+    Frame latest_;
+    Settings published_settings_;
+    bool log_failed_;
+
+    std::ofstream log_file_;
+    int open_format_;
+
+    float frame_ms_;
+    std::string sections_;
+    std::string bullet_sections_;
+    std::string largest_soft_body_;
+};
+
+}
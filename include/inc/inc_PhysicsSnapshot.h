@@ -0,0 +1,64 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <btBulletDynamicsCommon.h>
+
+namespace inc {
+
+// The moving state of every body in a world: soft body node positions and
+// velocities, rigid body transforms and velocities, packed one after another
+// into a single array. Restoring writes it straight back into the bodies,
+// so running a scene again from the same start doesn't rebuild anything.
+//
+// Only the state is kept, not the bodies: restore() refuses if bodies have
+// been added or removed, or a soft body's node count changed, since capture.
+class PhysicsSnapshot {
+public:
+    PhysicsSnapshot();
+
+    void capture(btCollisionWorld*);
+    // returns false, and leaves the world alone, if it no longer matches
+    bool restore(btCollisionWorld*);
+
+    bool empty() { return objects_.empty(); }
+    void clear();
+    // the size of the packed state
+    size_t num_bytes() { return data_.size() * sizeof(btVector3); }
+
+private:
+    // one entry per collision object, in the world's order, so checking the
+    // world still matches is a single walk down both lists
+    struct Object {
+        btCollisionObject* object;
+        int num_nodes; // -1 for a rigid or static body
+    };
+
+    bool matches(btCollisionWorld*);
+
+    std::vector<Object> objects_;
+    // soft bodies: position and velocity per node. rigid bodies: the three
+    // basis rows, the origin, and linear and angular velocity
+    btAlignedObjectArray<btVector3> data_;
+};
+
+}
@@ -0,0 +1,175 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <functional>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+
+#include <btBulletDynamicsCommon.h>
+
+namespace inc {
+class PhysicsWorld;
+
+// What drawing and picking need from the world after a step: every soft 
+// body's node positions and normals, and every other body's transform.
+struct RenderState {
+    struct Body {
+        int first; // into positions and normals
+        int num_nodes; // -1 if it isn't a soft body
+        btTransform transform;
+        // world space bounds, for culling
+        btVector3 aabb_min;
+        btVector3 aabb_max;
+        // Bullet never puts a soft body to sleep itself, so for one this is
+        // whether SoftSolid has settled it
+        bool sleeping;
+    };
+
+    RenderState();
+
+    // NULL if the object wasn't in the world when the state was made
+    const Body* find(const btCollisionObject*) const;
+
+    std::map<const btCollisionObject*, int> index;
+    btAlignedObjectArray<Body> bodies;
+    btAlignedObjectArray<btVector3> positions;
+    btAlignedObjectArray<btVector3> normals;
+    int step; // how many steps the thread had taken
+    int num_settled; // see SolidFactory, filled in by the publish function
+};
+
+// Three RenderStates: the physics thread writes one, the drawing reads 
+// another, and the third holds the newest finished one. Neither side ever
+// waits on the other for more than swapping two indices.
+class RenderStateBuffer {
+public:
+    RenderStateBuffer();
+
+    // physics thread only
+    RenderState& back() { return states_[back_]; }
+    void publish();
+
+    // drawing only. swaps in the newest state, false if there's been nothing
+    // new since the last call
+    bool acquire();
+    const RenderState& front() { return states_[front_]; }
+
+private:
+    RenderState states_[3];
+    int back_;
+    int middle_;
+    int front_;
+    bool fresh_;
+
+    boost::mutex mutex_;
+};
+
+// Steps a PhysicsWorld on its own thread at a fixed rate, publishing a 
+// RenderState after every step, so a slow step no longer holds up the 
+// frame. While it's running nothing else may touch the world directly: 
+// edits are either posted, to run on the physics thread before its next
+// step, or made inside a Pause.
+class PhysicsThread {
+public:
+    // the step function advances the world by dt and returns false if 
+    // nothing moved (ie everything has settled). Without one the world is
+    // just stepped
+    typedef std::function<bool (float)> StepFunction;
+    // adds whatever else the drawing needs to a state before it's published,
+    // on the physics thread
+    typedef std::function<void (RenderState&)> PublishFunction;
+
+    explicit PhysicsThread(PhysicsWorld*);
+    ~PhysicsThread(); // stops the thread
+
+    void set_step_function(const StepFunction& step) { step_ = step; }
+    void set_publish_function(const PublishFunction& publish) { 
+        publish_ = publish; 
+    }
+
+    // dt = simulated seconds per step, time_scale = simulated seconds per 
+    // wall clock second
+    void start(float dt, float time_scale);
+    void stop();
+    bool running() { return running_; }
+    void set_rate(float dt, float time_scale);
+
+    // runs fn on the physics thread before its next step, edits run in the
+    // order they're posted. If the thread isn't running fn is run right away
+    void post(const std::function<void ()>& fn);
+
+    // see RenderStateBuffer
+    bool acquire_render_state() { return buffer_.acquire(); }
+    const RenderState& render_state() { return buffer_.front(); }
+
+    int steps() { return steps_; }
+    float steps_per_second() { return steps_per_second_; }
+
+    // Holds the world still while it's in scope: waits for the step in 
+    // progress, runs everything posted so far, and keeps the thread from 
+    // stepping until it's destroyed. For edits that have to happen now, like
+    // adding a body or removing one that's about to be deleted. Pauses can
+    // be nested, and do nothing if the thread is NULL or not running.
+    class Pause {
+    public:
+        explicit Pause(PhysicsThread*);
+        ~Pause();
+
+    private:
+        Pause(const Pause&);
+        Pause& operator=(const Pause&);
+
+        PhysicsThread* thread_;
+    };
+
+private:
+    void run();
+    // with world_mutex_ held
+    void run_commands();
+    void publish();
+
+    PhysicsWorld* physics_;
+    StepFunction step_;
+    PublishFunction publish_;
+
+    std::tr1::shared_ptr<boost::thread> thread_;
+    // held by the thread for each step, and by a Pause
+    boost::recursive_mutex world_mutex_;
+    boost::mutex command_mutex_;
+    std::deque<std::function<void ()> > commands_;
+
+    RenderStateBuffer buffer_;
+
+    volatile bool quit_;
+    bool running_;
+    bool dirty_; // the world was changed inside a Pause
+
+    float time_step_;
+    float time_scale_;
+    volatile int steps_;
+    float steps_per_second_;
+};
+
+}
@@ -0,0 +1,145 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+#include <map>
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletSoftBody/btSoftBody.h>
+#include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
+
+#include <cinder/TriMesh.h>
+#include <cinder/Vector.h>
+
+class btSoftBodySolver;
+
+namespace inc {
+
+// The soft body material settings, the ones the mesh and sphere menus edit.
+// The defaults are the app's starting values.
+struct SoftBodyParams {
+    SoftBodyParams();
+
+    // write the settings into an existing body
+    void apply_mesh(btSoftBody*) const;
+    void apply_sphere(btSoftBody*) const;
+
+    // soft meshes
+    float kDF;
+    float kDP;
+    float kDG;
+    float kPR;
+    float kMT;
+
+    // soft spheres
+    float sphere_kLST;
+    float sphere_kVST;
+    float sphere_kDF;
+    float sphere_kDP;
+    float sphere_kPR;
+    float sphere_total_mass;
+};
+
+// Everything Bullet needs for one simulation: the collision setup, solvers,
+// soft body world info, gravity and material settings. None of it is static
+// or shared with another PhysicsWorld, so separate worlds can be stepped on
+// separate threads (see SweepDriver). SolidFactory owns the one the app 
+// draws.
+class PhysicsWorld {
+public:
+    // takes ownership of both, NULL gives a btDbvtBroadphase and the stock
+    // btDefaultSoftBodySolver
+    PhysicsWorld(btBroadphaseInterface* broadphase = NULL,
+        btSoftBodySolver* soft_body_solver = NULL);
+    ~PhysicsWorld();
+
+    btSoftRigidDynamicsWorld* world() { return world_; }
+    btSoftBodyWorldInfo& world_info() { return world_info_; }
+    btBroadphaseInterface* broadphase() { return broadphase_; }
+    btCollisionDispatcher* dispatcher() { return dispatcher_; }
+
+    float gravity() { return gravity_; }
+    void set_gravity(float);
+
+    // one step of exactly dt
+    void step(float dt);
+
+    // swaps the broadphase in place, moving every object's proxy over, so 
+    // bodies and constraints don't have to be rebuilt. Takes ownership.
+    void set_broadphase(btBroadphaseInterface*);
+
+    void delete_constraints();
+
+    // makes a soft body from the mesh with the mesh settings and adds it to
+    // the world. The caller owns the body and has to remove it before the 
+    // world is deleted. pointed_up = the mesh is a dome, so the vertices 
+    // anchored by lock_base_vertices are at the bottom rather than the top.
+    // Returns NULL if no triangles are left after welding
+    btSoftBody* create_soft_mesh(const ci::TriMesh&, ci::Vec3f scl,
+        bool lock_base_vertices, bool pointed_up);
+
+    // makes a soft ellipsoid with the sphere settings and adds it to the 
+    // world, owned by the caller like create_soft_mesh. Every sphere of the
+    // same radius and resolution is copied from one template body, so the
+    // hull and the cluster k-means only run once per shape
+    btSoftBody* create_soft_sphere(const btVector3& position, 
+        const btVector3& radius, int resolution);
+    int num_sphere_templates() { return (int) sphere_templates_.size(); }
+
+    // OBJ files split the vertices at every face, see MeshWelder. 
+    // tolerance 0 = exact float matches only
+    static std::tr1::shared_ptr<ci::TriMesh> remove_mesh_duplicates(
+        const ci::TriMesh& mesh, float tolerance = 0.0f);
+    // the vertices within a tenth of the mesh's height of its base
+    static std::tr1::shared_ptr<std::vector<int> > get_top_vertices(
+        const ci::TriMesh& mesh, bool pointed_up);
+    // per unit mass, anchored nodes don't count
+    static float kinetic_energy(const btSoftBody&);
+
+    SoftBodyParams params_;
+    // create_soft_mesh merges vertices closer than this, 0 = exact matches
+    float weld_tolerance_;
+
+private:
+    struct SphereKey {
+        float radius[3];
+        int resolution;
+
+        bool operator<(const SphereKey& k) const;
+    };
+
+    // made at the origin and never added to the world
+    btSoftBody* sphere_template(const SphereKey&);
+
+    btDefaultCollisionConfiguration* collision_configuration_;
+    btCollisionDispatcher* dispatcher_;
+    btBroadphaseInterface* broadphase_;
+    btSequentialImpulseConstraintSolver* solver_;
+    btSoftBodySolver* soft_body_solver_;
+    btSoftRigidDynamicsWorld* world_;
+    btSoftBodyWorldInfo world_info_;
+
+    std::map<SphereKey, btSoftBody*> sphere_templates_;
+
+    float gravity_;
+};
+
+}
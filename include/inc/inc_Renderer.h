@@ -24,6 +24,8 @@
 
 #include <inc/inc_Module.h>
 #include <inc/inc_Color.h>
+#include <inc/inc_GradientShader.h>
+#include <inc/inc_Frustum.h>
 #include <incApp.h>
 
 namespace inc {
@@ -96,6 +98,15 @@ public:
     bool* enable_lighting_ptr() { return &enable_lighting_; }
     bool enable_lighting() { return enable_lighting_; }
 
+    // skips solids and items wholly outside the camera's view
+    bool* frustum_culling_ptr() { return &frustum_culling_; }
+    // read only, counts from the last frame
+    int* num_drawn_ptr() { return &num_drawn_; }
+    int* num_culled_ptr() { return &num_culled_; }
+
+    // colors soft bodies by height, compiled in setup()
+    GradientShader& gradient_shader() { return gradient_shader_; }
+
     static Renderer& instance() { return *instance_; }
 
     // used for saving a higher resolution image
@@ -118,6 +129,13 @@ private:
 
     std::shared_ptr<Light> cam_light_;
 
+    GradientShader gradient_shader_;
+
+    Frustum frustum_;
+    bool frustum_culling_;
+    int num_drawn_;
+    int num_culled_;
+
     ci::ColorA base_color_;
     ci::ColorA top_color_;
     ci::ColorA line_color_;
@@ -0,0 +1,111 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <BulletSoftBody/btSoftBody.h>
+
+namespace inc {
+
+// Streams the node positions of a fixed set of soft bodies to a file after
+// every step, so a run can be looked at again, or exported at another step
+// or resolution, without simulating it again (see SimulationReplay).
+//
+// Positions are rounded to a multiple of quantum_ and stored as zigzag 
+// varints: every keyframe_interval_ steps the values themselves, in between
+// the change since the step before, which is usually a byte or two. The 
+// offsets of the keyframes are written at the end by stop(), so a log that
+// was never stopped can't be replayed.
+class SimulationRecorder {
+public:
+    SimulationRecorder();
+    ~SimulationRecorder(); // stops
+
+    // starts a new log of the bodies. They have to outlive the recording,
+    // or it has to be stopped first. Returns false if the file can't be 
+    // written
+    bool start(const std::string& path, const std::vector<btSoftBody*>&);
+    // appends the bodies' current positions
+    void record();
+    void stop();
+
+    bool recording() { return file_.is_open(); }
+    bool records(const btSoftBody*);
+    int num_steps() { return num_steps_; }
+
+    float quantum_; // in world units
+    int keyframe_interval_;
+
+private:
+    std::ofstream file_;
+    std::vector<btSoftBody*> bodies_;
+    int num_steps_;
+    float file_quantum_; // as of start
+    int file_keyframe_interval_;
+
+    std::vector<unsigned long long> keyframes_;
+    std::vector<int> previous_; // quantized, of the last step
+    std::vector<unsigned char> buffer_;
+};
+
+// Reads a log made by SimulationRecorder and puts any step of it back into
+// the bodies, without running Bullet. Seeking starts from the nearest 
+// keyframe before the step, or carries on from the current one when 
+// scrubbing forwards.
+class SimulationReplay {
+public:
+    SimulationReplay();
+
+    // false if the file is missing, or isn't a finished log
+    bool open(const std::string& path);
+    void close();
+    bool is_open() { return file_.is_open(); }
+
+    int num_steps() { return num_steps_; }
+    int step() { return step_; }
+    // the node count of each body, in the order they were recorded
+    const std::vector<int>& body_sizes() { return body_sizes_; }
+    // true if the bodies are the ones in the log, going by node counts
+    bool matches(const std::vector<btSoftBody*>&);
+
+    // decodes the step, false if it's out of range or the file is bad
+    bool seek(int step);
+    // writes the decoded step into the bodies, with no velocity, and 
+    // returns false, leaving them alone, if they don't match
+    bool apply(const std::vector<btSoftBody*>&);
+
+private:
+    bool read_frame(bool keyframe);
+
+    std::ifstream file_;
+    float quantum_;
+    int keyframe_interval_;
+    int num_steps_;
+    std::vector<int> body_sizes_;
+    std::vector<unsigned long long> keyframes_;
+
+    int step_; // -1 before the first seek, or after a bad read
+    std::vector<int> values_; // quantized
+};
+
+}
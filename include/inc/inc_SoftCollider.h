@@ -0,0 +1,101 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <utility>
+
+#include <BulletSoftBody/btSoftBody.h>
+
+namespace inc {
+
+// How soft bodies collide with each other. Bullet's vertex-face test 
+// (VF_SS) keeps a tree of every node and face and walks two of them per 
+// overlapping pair, which is most of the step in a packed scene. The 
+// alternatives are cluster against cluster only (CL_SS), which is much
+// coarser, or the same vertex-face test as Bullet run against a hash grid
+// of each body's faces. The grid is built at most once a step, the first
+// time a pair needs it, and shared by every pair the body is in.
+//
+// The hashed contacts are Bullet's own soft contacts, made exactly the way 
+// VF_SS makes them, so they're solved (and grouped into islands by 
+// ParallelSoftBodySolver) like any others.
+class SoftCollider {
+public:
+    enum Mode {
+        AUTO = 0, // VERTEX_FACE up to auto_hash_nodes_ nodes, then HASHED
+        VERTEX_FACE,
+        CLUSTERS,
+        HASHED
+    };
+
+    SoftCollider();
+
+    // sets the body's collision flags for the mode, generating clusters if 
+    // it needs them and has none. Returns the mode it ended up with
+    Mode set_mode(btSoftBody*, Mode);
+    // AUTO if the body was never set
+    Mode mode(const btSoftBody*) const;
+    // has to be called before a body is deleted
+    void remove(const btSoftBody*);
+
+    // once a step, before collision detection
+    void begin_step() { ++step_; }
+
+    // true if the pair is collided here rather than by Bullet: one of them
+    // is HASHED, or they're in modes Bullet can't collide with each other
+    // (it only collides two bodies on a method both have switched on)
+    bool handles(const btSoftBody*, const btSoftBody*) const;
+    // adds the vertex-face contacts of the pair, both ways round
+    void collide(btSoftBody*, btSoftBody*);
+
+    int auto_hash_nodes_;
+    int num_clusters_; // for CLUSTERS bodies that have none
+
+private:
+    // the cells each face's bounds touch, as (cell key, face) sorted by key
+    struct Grid {
+        Grid();
+
+        int step;
+        btScalar cell_size;
+        std::vector<std::pair<unsigned int, int> > entries;
+    };
+
+    const Grid& grid(const btSoftBody*);
+    // nodes of a against faces of b, contacts go to a
+    void collide_nodes(btSoftBody* a, btSoftBody* b, btScalar margin);
+    void add_contact(btSoftBody* a, btSoftBody* b, btSoftBody::Node&, 
+        btSoftBody::Face&, btScalar margin);
+
+    static unsigned int key(int x, int y, int z);
+    static int cell(btScalar v, btScalar cell_size);
+
+    std::map<const btSoftBody*, Mode> modes_;
+    std::map<const btSoftBody*, Grid> grids_;
+    int step_;
+
+    // marks the faces already tested against the current node
+    std::vector<int> stamps_;
+    int stamp_;
+};
+
+}
@@ -20,16 +20,26 @@
 #pragma once
 
 #include <deque>
+#include <vector>
 
 #include <btBulletDynamicsCommon.h>
 #include <LinearMath/btIDebugDraw.h>
 #include <BulletSoftBody/btSoftBody.h>
 #include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
 
+#include <cinder/gl/gl.h>
 #include <cinder/app/MouseEvent.h>
+#include <cinder/AxisAlignedBox.h>
+#include <cinder/Timer.h>
 
 #include <inc/inc_GraphicItem.h>
 #include <inc/inc_Module.h>
+#include <inc/inc_CollisionShapeCache.h>
+#include <inc/inc_PhysicsWorld.h>
+#include <inc/inc_PhysicsSnapshot.h>
+#include <inc/inc_PhysicsThread.h>
+#include <inc/inc_PhysicsProfiler.h>
+#include <inc/inc_SimulationRecorder.h>
 
 namespace cinder {
 class TriMesh;
@@ -37,6 +47,7 @@ class TriMesh;
 
 namespace inc {
 class Exporter;
+class EmbeddedMesh;
     
 class Solid {
 public:
@@ -54,6 +65,16 @@ public:
     virtual void remove_force();
     virtual ci::Vec3f* force_ptr(); // the force menu hooks into this
     virtual btCollisionObject& collision_object();
+    // called before every fixed physics step, so drawing can interpolate
+    // between the last two steps
+    virtual void store_previous_state();
+
+    // called once a frame after the world has been stepped. dt = the length
+    // of the frame, energy = the settle threshold, dwell = how long the body
+    // has to stay under it, in seconds
+    virtual void update_settle(float dt, float energy, float dwell);
+    virtual bool settled() { return false; }
+    virtual void wake();
 
     virtual bool detect_selection(ci::Ray); 
     virtual void select();   
@@ -63,7 +84,17 @@ public:
     bool visible();
     void set_visible(bool);
 
+    // a world space box around what draw() draws, for culling. Returns 
+    // false if there isn't one, and the solid should always be drawn
+    bool bounds(ci::AxisAlignedBox3f&);
+
 protected:
+    // the physics thread's latest copy of the transform if it is running,
+    // otherwise the body's own
+    btTransform published_transform();
+    // Bullet's bounds for the body, from the same place as the transform
+    virtual bool aabb(btVector3& min, btVector3& max);
+
     SolidGraphicItem* graphic_item_;
     btCollisionObject* body_;
     btDynamicsWorld* world_;
@@ -87,11 +118,30 @@ public:
     virtual void set_force(ci::Vec3f);
     virtual btRigidBody& rigid_body();
     virtual btRigidBody* rigid_body_ptr();
+
+    // Override
+    virtual void store_previous_state();
+
+protected:
+    // Override
+    virtual bool aabb(btVector3& min, btVector3& max);
+
+private:
+    btTransform previous_transform_;
+    bool has_previous_transform_;
 };
 
 class SoftSolid : public Solid {
 public:
-    SoftSolid(SolidGraphicItem*, btSoftBody*, btDynamicsWorld*);
+    // which of SolidFactory's parameter sets the body follows
+    enum MaterialGroup {
+        NO_MATERIAL = 0,
+        MESH_MATERIAL, // kDF_, kDP_ ...
+        SPHERE_MATERIAL // sphere_kLST_, sphere_kVST_ ...
+    };
+
+    SoftSolid(SolidGraphicItem*, btSoftBody*, btDynamicsWorld*, 
+        MaterialGroup = NO_MATERIAL);
     virtual ~SoftSolid();
 
     // Override
@@ -113,10 +163,60 @@ public:
     // Override
     virtual bool detect_selection(ci::Ray);
 
+    // Override
+    virtual void store_previous_state();
+    // returns NULL if drawing shouldn't interpolate, otherwise the node
+    // positions from before the last physics step
+    const btAlignedObjectArray<btVector3>* previous_positions();
+
+    // Override
+    virtual void update_settle(float dt, float energy, float dwell);
+    // Override
+    virtual bool settled() { return settled_; }
+    // settled() as of the state being drawn, for the main thread. While the
+    // physics thread runs settled_ is only its to read
+    bool drawn_settled();
+    // Override
+    virtual void wake();
+
+    // kinetic energy per unit mass of the free nodes, as of the last 
+    // update_settle
+    float kinetic_energy() { return kinetic_energy_; }
+
+    MaterialGroup material_group() { return material_group_; }
+
     void set_flip_normals(bool f) { graphic_item_->flip_normals_ = true; }
+
+    // the full resolution mesh when the body is only a cage for it, 
+    // otherwise NULL. Drawing and saving use it in place of the body's faces
+    EmbeddedMesh* embedded_mesh() { return embedded_mesh_.get(); }
+    void set_embedded_mesh(std::tr1::shared_ptr<EmbeddedMesh> m) { 
+        embedded_mesh_ = m; 
+    }
+
+protected:
+    // Override
+    virtual bool aabb(btVector3& min, btVector3& max);
+
+private:
+    bool touching_dynamic_object();
+    void settle();
+
+    btAlignedObjectArray<btVector3> previous_positions_;
+
+    bool settled_;
+    float settle_time_; // how long the energy has been under the threshold
+    float kinetic_energy_;
+
+    MaterialGroup material_group_;
+
+    std::tr1::shared_ptr<EmbeddedMesh> embedded_mesh_;
 };
 
 class DebugDraw;
+class TaskPool;
+class ParallelSoftBodySolver;
+class SoftCollider;
 
 typedef std::shared_ptr<Solid> SolidPtr;
 typedef std::shared_ptr<RigidSolid> RigidSolidPtr;
@@ -124,6 +224,18 @@ typedef std::shared_ptr<SoftSolid> SoftSolidPtr;
 
 class SolidFactory : public Module {
 public:
+    enum StepMode {
+        FRAME_LOCKED = 0, // one stepSimulation(1, 10) per frame
+        FIXED_STEP, // wall clock accumulator with a fixed internal dt
+        ADAPTIVE_STEP // like FIXED_STEP, but drops steps over the frame budget
+    };
+
+    enum BroadphaseType {
+        AXIS_SWEEP = 0, // btAxisSweep3 with fixed bounds of +/- world_size_
+        DYNAMIC_TREE, // btDbvtBroadphase, no bounds
+        AUTO_SWEEP // a sweep fitted to the scene, refitted when things leave it
+    };
+
     SolidFactory();
     ~SolidFactory();
 
@@ -131,7 +243,11 @@ public:
     void update();
     void draw();
 
-    float time_step();
+    float time_step(); // the length of the last frame, in seconds
+    // advances the world by exactly one step of dt, with no wall clock, and
+    // runs the settle check with dt as the elapsed time. For stepping 
+    // without a window, see FormFinder
+    void step(float dt);
     btDynamicsWorld* dynamics_world();
     btSoftRigidDynamicsWorld* soft_dynamics_world();
     float gravity();
@@ -141,6 +257,93 @@ public:
     float* gravity_ptr();
 
     void update_object_gravity(); // this applies any gravity changes to all objects
+    void wake_all_solids();
+
+    // saves the state of every body, so the scene can be run again from 
+    // here without rebuilding it. Restoring fails, returning false, if 
+    // solids were added or removed since the save
+    void save_snapshot();
+    bool restore_snapshot();
+    bool save_snapshot_button(bool);
+    bool restore_snapshot_button(bool);
+
+    // writes every soft body's nodes to recording_name_ after each step 
+    // (each frame when FRAME_LOCKED), see SimulationRecorder. Replaying 
+    // puts a recorded step back into the bodies and stops stepping the 
+    // world, which only works on the scene the recording was made from. 
+    // The physics thread is stopped while replaying
+    bool adjust_recording(bool);
+    bool adjust_replaying(bool);
+    bool adjust_replay_step(int);
+    bool* recording_ptr() { return &recording_; }
+    bool* replaying_ptr() { return &replaying_; }
+    int* replay_step_ptr() { return &replay_step_; }
+    int* replay_num_steps_ptr() { return &replay_num_steps_; }
+    std::string* recording_name_ptr() { return &recording_name_; }
+    bool replaying() { return replaying_; }
+    int replay_num_steps() { return replay_num_steps_; }
+    // returns false, leaving the bodies alone, if it isn't replaying or the
+    // step isn't in the recording
+    bool show_replay_step(int);
+    // called as a soft body is taken out of the world
+    void soft_body_removed(btSoftBody*);
+
+    // between 0 and 1, how far the rendering is between the last two steps
+    float interpolation_alpha() { return interpolation_alpha_; }
+    bool interpolating() { 
+        return step_mode_ != FRAME_LOCKED && !physics_thread_->running() &&
+            !replaying_; 
+    }
+    int last_sub_steps() { return last_sub_steps_; }
+
+    // menu hooks
+    bool adjust_step_mode(int);
+    int* step_mode_ptr() { return &step_mode_; }
+    float* fixed_time_step_ptr() { return &fixed_time_step_; }
+    int* max_sub_steps_ptr() { return &max_sub_steps_; }
+    float* time_scale_ptr() { return &time_scale_; }
+    float* physics_budget_ptr() { return &physics_budget_; }
+    int* last_sub_steps_ptr() { return &last_sub_steps_; }
+
+    // soft body threading, see ParallelSoftBodySolver
+    bool adjust_num_threads(int);
+    bool adjust_parallel_soft_bodies(bool);
+    bool adjust_deterministic(bool);
+    int* num_threads_ptr() { return &num_threads_; }
+    bool* parallel_soft_bodies_ptr() { return &parallel_soft_bodies_; }
+    bool* deterministic_ptr() { return &deterministic_; }
+
+    bool adjust_broadphase_type(int);
+    bool adjust_world_size(float);
+    bool rebuild_broadphase_button(bool);
+    int* broadphase_type_ptr() { return &broadphase_type_; }
+    float* world_size_ptr() { return &world_size_; }
+    // read only stats, updated every frame
+    int* broadphase_pairs_ptr() { return &broadphase_pairs_; }
+    int* manifolds_ptr() { return &manifolds_; }
+    int* objects_outside_ptr() { return &objects_outside_; }
+
+    // settled soft bodies are put to sleep and drawn from a display list,
+    // when nothing in the world is awake the world isn't stepped at all
+    bool adjust_allow_settling(bool);
+    bool* allow_settling_ptr() { return &allow_settling_; }
+    float* settle_energy_ptr() { return &settle_energy_; }
+    float* settle_time_ptr() { return &settle_time_; }
+    int* num_settled_ptr() { return &num_settled_; }
+    int num_settled() { return num_settled_; }
+
+    // steps the world on its own thread at the fixed time step, see 
+    // PhysicsThread. Drawing and picking then read the thread's latest 
+    // RenderState rather than the bodies
+    bool adjust_threaded(bool);
+    bool* threaded_ptr() { return &threaded_; }
+    float* physics_steps_per_second_ptr() { return &physics_steps_per_second_; }
+    PhysicsThread* physics_thread() { return physics_thread_; }
+    // NULL unless the physics thread is running
+    const RenderState* render_state();
+    // runs an edit to the world on the physics thread before its next step,
+    // or straight away if it isn't running
+    void post(const std::function<void ()>&);
         
     static RigidSolidPtr create_rigid_sphere(ci::Vec3f position, ci::Vec3f radius);
     static SoftSolidPtr create_soft_sphere(ci::Vec3f position, ci::Vec3f radius);
@@ -152,6 +355,7 @@ public:
         ci::Vec3f pos, ci::Vec3f radius, int w, int h, int d);
     static std::tr1::shared_ptr<std::deque<SolidPtr> > create_rigid_sphere_spring_matrix(
         ci::Vec3f pos, ci::Vec3f radius, int w, int h, int d);
+    // empty if the mesh has no triangles left after welding
     static SoftSolidPtr create_soft_mesh(std::tr1::shared_ptr<ci::TriMesh>,
         ci::Vec3f scl = ci::Vec3f::one(), bool lock_base_vertices = true);
 
@@ -173,6 +377,12 @@ public:
     static SolidFactory* instance_ptr();
 
     btSoftBodyWorldInfo& soft_body_world_info();
+    // the scene's world and material settings, made in setup()
+    PhysicsWorld& physics() { return *physics_; }
+    CollisionShapeCache& shape_cache() { return shape_cache_; }
+    TaskPool& task_pool() { return *task_pool_; }
+    PhysicsProfiler& profiler() { return profiler_; }
+    DebugDraw& debug_draw() { return *debug_draw_; }
 
     void delete_constraints();
 
@@ -184,24 +394,77 @@ public:
     bool adjust_kPR(float);
     bool adjust_kMT(float);
 
-    float* kDF_ptr() { return &kDF_; }
-    float* kDP_ptr() { return &kDP_; }
-    float* kDG_ptr() { return &kDG_; }
-    float* kPR_ptr() { return &kPR_; }
-    float* kMT_ptr() { return &kMT_; }
-
-    float* sphere_kLST_ptr() { return &sphere_kLST_; }
-    float* sphere_kVST_ptr() { return &sphere_kVST_; }
-    float* sphere_kDF_ptr() { return &sphere_kDF_; }
-    float* sphere_kDP_ptr() { return &sphere_kDP_; }
-    float* sphere_kPR_ptr() { return &sphere_kPR_; }
-    float* sphere_total_mass_ptr() { return &sphere_total_mass_; }
+    float* kDF_ptr() { return &physics_->params_.kDF; }
+    float* kDP_ptr() { return &physics_->params_.kDP; }
+    float* kDG_ptr() { return &physics_->params_.kDG; }
+    float* kPR_ptr() { return &physics_->params_.kPR; }
+    float* kMT_ptr() { return &physics_->params_.kMT; }
+
+    float* sphere_kLST_ptr() { return &physics_->params_.sphere_kLST; }
+    float* sphere_kVST_ptr() { return &physics_->params_.sphere_kVST; }
+    float* sphere_kDF_ptr() { return &physics_->params_.sphere_kDF; }
+    float* sphere_kDP_ptr() { return &physics_->params_.sphere_kDP; }
+    float* sphere_kPR_ptr() { return &physics_->params_.sphere_kPR; }
+    float* sphere_total_mass_ptr() { return &physics_->params_.sphere_total_mass; }
+    // used by the next mesh that's made
+    float* weld_tolerance_ptr() { return &physics_->weld_tolerance_; }
+    // meshes are simulated as a decimated cage with the full mesh carried
+    // along for drawing and saving, see EmbeddedMesh. The resolution is 
+    // the number of cage cells across the mesh's longest side
+    bool* simulate_cage_ptr() { return &simulate_cage_; }
+    int* cage_resolution_ptr() { return &cage_resolution_; }
+
+    // how new soft bodies collide with each other, a SoftCollider::Mode. 
+    // The button sets the selected ones to it
+    SoftCollider& soft_collider();
+    int* soft_collision_mode_ptr() { return &soft_collision_mode_; }
+    int* auto_hash_nodes_ptr() { return &auto_hash_nodes_; }
+    bool apply_soft_collision_button(bool);
+
+    bool adjust_sphere_kLST(float);
+    bool adjust_sphere_kVST(float);
+    bool adjust_sphere_kDF(float);
+    bool adjust_sphere_kDP(float);
+    bool adjust_sphere_kPR(float);
+    bool adjust_sphere_total_mass(float);
+
+    // these write the current parameters into an existing body
+    static void apply_mesh_params(btSoftBody*);
+    static void apply_sphere_params(btSoftBody*);
 
     bool draw_bullet_debug_;
 
 private:
     void init_physics();
-    bool physics_param_changed();
+    // hands the menu's gravity and settle settings to the step, see 
+    // StepSettings
+    void post_step_settings();
+    // applies the parameters to every live body in the group, none of 
+    // these change topology so nothing is rebuilt
+    bool physics_param_changed(SoftSolid::MaterialGroup);
+    void apply_gravity_change();
+    void apply_object_gravity(float);
+    void step_fixed(double frame_time);
+    // a sweep has room for extra_objects more than are in the world, and 
+    // as many again
+    btBroadphaseInterface* create_broadphase(int extra_objects = 0);
+    void rebuild_broadphase(int extra_objects = 0);
+    // objects outside a fitted sweep, or a sweep three quarters full
+    bool broadphase_needs_rebuild();
+    // rebuilds the sweep first if n more objects wouldn't fit
+    void reserve_broadphase(int n);
+    void update_broadphase_stats();
+    // returns false if there is nothing in the world with finite bounds
+    bool scene_bounds(btVector3& min, btVector3& max);
+    bool world_awake();
+    // returns how many soft bodies have settled
+    int update_settling(float dt);
+    // the physics thread's step, see PhysicsThread::StepFunction
+    bool step_threaded(float dt);
+    void store_previous_states();
+    void apply_soft_collision(btSoftBody*);
+    // every soft body in the world, in the order they were added
+    std::vector<btSoftBody*> recorded_bodies();
         
     static btSoftBody* create_bullet_soft_sphere(ci::Vec3f position, 
         ci::Vec3f radius, float res);
@@ -212,22 +475,18 @@ private:
     static btRigidBody* create_bullet_rigid_sphere(ci::Vec3f position,
         float radius);
 
-    static std::tr1::shared_ptr<ci::TriMesh> remove_mesh_duplicates(
-        const ci::TriMesh& mesh);
-    static std::tr1::shared_ptr<std::vector<int> > get_top_vertices(
-        const ci::TriMesh& mesh);
-
-    //btDynamicsWorld* dynamics_world_;
-    btSoftRigidDynamicsWorld* dynamics_world_;
-    btSoftBodyWorldInfo soft_body_world_info_;
-    btDefaultCollisionConstructionInfo collision_info_;
-
-    btDefaultCollisionConfiguration* collision_configuration_;
-    btCollisionDispatcher* dispatcher_;
-    btBroadphaseInterface* broadphase_;
-    btSequentialImpulseConstraintSolver* solver_;
+    PhysicsWorld* physics_;
+    PhysicsThread* physics_thread_;
+    ParallelSoftBodySolver* soft_body_solver_; // owned by physics_
+    TaskPool* task_pool_;
     DebugDraw* debug_draw_;
 
+    CollisionShapeCache shape_cache_;
+    PhysicsSnapshot snapshot_;
+    PhysicsProfiler profiler_;
+    SimulationRecorder recorder_;
+    SimulationReplay replay_;
+
     static std::deque<btTriangleMesh*> mesh_cleanup_;
 
     static ci::ColorA sphere_color_;
@@ -235,22 +494,66 @@ private:
 
     double time_step_;
     double last_time_;
+    ci::Timer timer_;
+
+    int step_mode_;
+    float fixed_time_step_; // seconds
+    int max_sub_steps_;
+    float time_scale_; // simulated seconds per wall clock second
+    float physics_budget_; // milliseconds per frame, ADAPTIVE_STEP only
+    double accumulator_;
+    float interpolation_alpha_;
+    int last_sub_steps_;
+
+    int num_threads_;
+    bool parallel_soft_bodies_;
+    bool deterministic_;
+
+    int broadphase_type_;
+    float world_size_; // half the width of the AXIS_SWEEP box
+    bool has_sweep_bounds_;
+    btVector3 sweep_min_;
+    btVector3 sweep_max_;
+    int sweep_capacity_; // the handles the sweep was made with
+    int broadphase_pairs_;
+    int manifolds_;
+    int objects_outside_;
+
+    bool allow_settling_;
+    float settle_energy_;
+    float settle_time_;
+    int num_settled_;
+
+    // what the step reads of the settings above and gravity_, which the 
+    // menu writes from the main thread. A copy is posted each frame, so 
+    // while the physics thread runs it never reads the menu's own
+    struct StepSettings {
+        float gravity;
+        bool allow_settling;
+        float settle_energy;
+        float settle_time;
+    };
+    StepSettings step_settings_;
+    int thread_num_settled_; // published through RenderState
+
+    bool threaded_;
+    float physics_steps_per_second_;
+    int last_thread_steps_;
 
     float gravity_;
     float last_gravity_;
 
-    static float kDF_;
-    static float kDP_;
-    static float kDG_;
-    static float kPR_;
-    static float kMT_;
+    bool simulate_cage_;
+    int cage_resolution_;
 
-    static float sphere_kLST_;
-    static float sphere_kVST_;
-    static float sphere_kDF_;
-    static float sphere_kDP_;
-    static float sphere_kPR_;
-    static float sphere_total_mass_;
+    int soft_collision_mode_;
+    int auto_hash_nodes_;
+
+    bool recording_;
+    bool replaying_;
+    int replay_step_;
+    int replay_num_steps_;
+    std::string recording_name_; // without the extension
 
     static SolidFactory* instance_;
 
@@ -279,6 +582,9 @@ enum	DebugDrawModes
 };
 */
 
+// Collects the lines Bullet draws into one array, which flush() draws with
+// a single call. Past max_lines_ in a frame the rest are dropped, and with
+// a decimation_ of n only every nth line is kept.
 class DebugDraw : public btIDebugDraw {
 public:
     DebugDraw();
@@ -291,9 +597,31 @@ public:
     void setDebugMode(int mode);
     int getDebugMode() const; 
 
+    // draws and clears the lines collected since the last flush
+    void flush();
+
+    int* max_lines_ptr() { return &max_lines_; }
+    int* decimation_ptr() { return &decimation_; }
+    // read only, as of the last flush
+    int* lines_drawn_ptr() { return &lines_drawn_; }
+    int* lines_dropped_ptr() { return &lines_dropped_; }
+
 private:
+    struct Vertex {
+        GLfloat position[3];
+        GLubyte color[4];
+    };
+
     int mode_;
 
+    std::vector<Vertex> vertices_;
+    int max_lines_;
+    int decimation_;
+    int lines_offered_; // since the last flush
+    int lines_over_limit_; // since the last flush
+    int lines_drawn_;
+    int lines_dropped_;
+
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A cache of a ci::BSpline3f's positions at a list of parameters. Each 
+// position is its own getPosition call, nothing is shared between them. 
+// The results are kept until the spline or the parameters change, so asking
+// again for the same curve at the same parameters (ie redrawing a curve 
+// every frame) doesn't touch the spline. A new resolution resamples it all.
+
+#pragma once
+
+#include <vector>
+
+#include <cinder/BSpline.h>
+#include <cinder/Vector.h>
+
+namespace inc {
+
+class SplineSampler {
+public:
+    SplineSampler();
+
+    // returns true if the spline was resampled
+    bool sample(std::tr1::shared_ptr<ci::BSpline3f>, 
+        const std::vector<float>& params);
+    // samples res points evenly spaced between 0 and 1 (inclusive)
+    bool sample_uniform(std::tr1::shared_ptr<ci::BSpline3f>, int res);
+
+    // drops the cached samples and the reference to the spline
+    void clear();
+
+    int size() const { return (int) params_.size(); }
+
+    const std::vector<float>& params() const { return params_; }
+    const std::vector<ci::Vec3f>& positions() const { return positions_; }
+
+private:
+    std::tr1::shared_ptr<ci::BSpline3f> spline_;
+
+    std::vector<float> params_;
+    std::vector<ci::Vec3f> positions_;
+};
+
+}
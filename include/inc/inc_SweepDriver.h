@@ -0,0 +1,103 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cinder/TriMesh.h>
+#include <cinder/Vector.h>
+
+#include <inc/inc_PhysicsWorld.h>
+
+namespace inc {
+
+// Runs one soft mesh under a list of material settings, each variant in its
+// own PhysicsWorld, several at once on a TaskPool, and keeps the final shape
+// and a few numbers from each. The worlds share nothing, so the variants 
+// can't affect each other and the results don't depend on the thread count.
+//
+// Bullet's built in profiler (CProfileManager) is global and isn't thread
+// safe. inc_headless defines BT_NO_PROFILE so the variants can run at once,
+// and the Bullet libraries it links must be built with BT_NO_PROFILE as 
+// well, or every world still writes the profiler from inside Bullet. 
+// Without the define the variants run one at a time whatever num_threads_ 
+// says.
+class SweepDriver {
+public:
+    struct Variant {
+        SoftBodyParams params;
+        float gravity;
+    };
+
+    struct Result {
+        Variant variant;
+        bool converged;
+        int steps;
+        double seconds;
+        float kinetic_energy; // per unit mass, at the last step
+        float volume;
+        ci::Vec3f min; // bounds of the final shape
+        ci::Vec3f max;
+        // welded, one vertex per node. NULL if the mesh welded down to nothing
+        std::tr1::shared_ptr<ci::TriMesh> mesh;
+    };
+
+    SweepDriver();
+
+    void add_variant(const Variant&);
+    // every pressure with every damping, on top of base
+    void add_grid(const SoftBodyParams& base, float gravity,
+        const std::vector<float>& pressures, 
+        const std::vector<float>& dampings);
+    void clear();
+
+    int num_variants() { return (int) variants_.size(); }
+
+    // blocks until every variant has settled or run out of steps. The 
+    // arguments are as PhysicsWorld::create_soft_mesh
+    void run(const ci::TriMesh& mesh, ci::Vec3f scl, bool lock_base_vertices,
+        bool pointed_up);
+
+    const std::vector<Result>& results() { return results_; }
+    // false if this build has to run the variants one at a time
+    static bool can_run_threaded();
+    // one line per variant
+    std::string summary();
+
+    float time_step_; // simulated seconds per step
+    int max_steps_;
+    // the same test as SolidFactory's settling, in simulated seconds
+    float settle_energy_;
+    float settle_time_;
+    int num_threads_; // 0 = one per hardware thread, 1 by default
+    float weld_tolerance_; // see MeshWelder
+
+private:
+    void run_variant(int index, const ci::TriMesh& mesh, ci::Vec3f scl,
+        bool lock_base_vertices, bool pointed_up);
+
+    static std::tr1::shared_ptr<ci::TriMesh> soft_body_mesh(const btSoftBody&);
+
+    std::vector<Variant> variants_;
+    std::vector<Result> results_;
+};
+
+}
@@ -0,0 +1,78 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+#include <functional>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace inc {
+
+// A fixed set of worker threads used to split loops across cores. The 
+// calling thread does its share of the work, so a pool of 1 thread runs 
+// everything inline. parallel_for isn't reentrant: don't call it from
+// inside a job, or from two threads at once.
+class TaskPool {
+public:
+    // 0 threads = one per hardware thread
+    explicit TaskPool(int num_threads = 0);
+    ~TaskPool();
+
+    void set_num_threads(int);
+    int num_threads();
+
+    // calls fn(i) for every i in [begin, end) and returns once they're all
+    // done. with static_chunks each thread gets one contiguous slice of the
+    // range, always the same one for the same range and thread count,
+    // otherwise threads take small batches as they finish.
+    void parallel_for(int begin, int end, const std::function<void (int)>& fn,
+        bool static_chunks = false);
+
+    static int hardware_threads();
+
+private:
+    void start(int num_threads);
+    void stop();
+    void worker(int id, int generation);
+    void run_job(int id);
+
+    std::vector<std::tr1::shared_ptr<boost::thread> > workers_;
+
+    boost::mutex mutex_;
+    boost::condition_variable work_ready_;
+    boost::condition_variable work_done_;
+
+    // the current job, only changed while the workers are idle
+    const std::function<void (int)>* job_;
+    int begin_;
+    int end_;
+    int next_;
+    int grain_;
+    bool static_chunks_;
+
+    int generation_;
+    int busy_;
+    bool quit_;
+};
+
+}
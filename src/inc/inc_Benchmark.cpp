@@ -0,0 +1,155 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <deque>
+#include <sstream>
+
+#include <cinder/app/App.h>
+#include <cinder/Timer.h>
+
+#include <inc/inc_Benchmark.h>
+#include <inc/inc_Solid.h>
+#include <inc/inc_TaskPool.h>
+#include <inc/inc_SoftCollider.h>
+
+namespace inc {
+
+SoftBodyBenchmark::SoftBodyBenchmark() {
+    width_ = 5;
+    height_ = 5;
+    depth_ = 5;
+    radius_ = 5.0f;
+    steps_ = 60;
+}
+
+void SoftBodyBenchmark::run() {
+    TaskPool& pool = SolidFactory::instance().task_pool();
+    int original_threads = pool.num_threads();
+    int max_threads = TaskPool::hardware_threads();
+
+    std::vector<int> thread_counts;
+
+    for (int n = 1; n < max_threads; n *= 2)
+        thread_counts.push_back(n);
+
+    thread_counts.push_back(max_threads);
+
+    results_.clear();
+
+    for (size_t i = 0; i < thread_counts.size(); ++i) {
+        float steps_per_second = time_steps(thread_counts[i]);
+
+        results_.push_back(std::make_pair(thread_counts[i], steps_per_second));
+
+        ci::app::console() << "Soft body benchmark: " << thread_counts[i] <<
+            " threads, " << steps_per_second << " steps/sec" << std::endl;
+    }
+
+    pool.set_num_threads(original_threads);
+}
+
+void SoftBodyBenchmark::run_collision_modes() {
+    int* mode = SolidFactory::instance().soft_collision_mode_ptr();
+    int original_mode = *mode;
+    int num_threads = SolidFactory::instance().task_pool().num_threads();
+
+    collision_results_.clear();
+
+    for (int m = SoftCollider::VERTEX_FACE; m <= SoftCollider::HASHED; ++m) {
+        // the spheres take the mode as they're made
+        *mode = m;
+
+        float steps_per_second = time_steps(num_threads);
+
+        collision_results_.push_back(std::make_pair(m, steps_per_second));
+
+        ci::app::console() << "Soft collision benchmark: mode " << m << 
+            ", " << steps_per_second << " steps/sec" << std::endl;
+    }
+
+    *mode = original_mode;
+}
+
+float SoftBodyBenchmark::time_steps(int num_threads) {
+    // the benchmark steps the world itself
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    SolidFactory::instance().task_pool().set_num_threads(num_threads);
+
+    // a new matrix for every run, so each starts from the same state
+    std::tr1::shared_ptr<std::deque<SolidPtr> > spheres = 
+        SolidFactory::create_soft_sphere_matrix(
+        ci::Vec3f(0.0f, radius_ * 2.0f, 0.0f), ci::Vec3f::one() * radius_,
+        width_, height_, depth_);
+
+    btSoftRigidDynamicsWorld* world = SolidFactory::instance().soft_dynamics_world();
+    const float dt = 1.0f / 60.0f;
+
+    // the first step builds the broadphase pairs, don't count it
+    world->stepSimulation(dt, 0, dt);
+
+    ci::Timer timer(true);
+
+    for (int i = 0; i < steps_; ++i)
+        world->stepSimulation(dt, 0, dt);
+
+    timer.stop();
+
+    // deleting the solids removes the bodies from the world
+    spheres.reset();
+
+    if (timer.getSeconds() <= 0.0)
+        return 0.0f;
+
+    return (float) (steps_ / timer.getSeconds());
+}
+
+std::string SoftBodyBenchmark::summary() {
+    std::stringstream ss;
+
+    ss.precision(3);
+
+    for (size_t i = 0; i < results_.size(); ++i) {
+        if (i > 0)
+            ss << "  ";
+
+        ss << results_[i].first << ": " << results_[i].second;
+    }
+
+    return ss.str();
+}
+
+std::string SoftBodyBenchmark::collision_summary() {
+    const char* names[] = { "auto", "vertex-face", "clusters", "hashed" };
+    std::stringstream ss;
+
+    ss.precision(3);
+
+    for (size_t i = 0; i < collision_results_.size(); ++i) {
+        if (i > 0)
+            ss << "  ";
+
+        ss << names[collision_results_[i].first] << ": " << 
+            collision_results_[i].second;
+    }
+
+    return ss.str();
+}
+
+}
@@ -0,0 +1,152 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cinder/app/App.h>
+
+#include <inc/inc_CollisionShapeCache.h>
+
+namespace inc {
+
+CollisionShapeCache::CollisionShapeCache() {
+    total_references_ = 0;
+}
+
+CollisionShapeCache::~CollisionShapeCache() {
+#ifdef TRACE_DTORS
+    ci::app::console() << "Deleting CollisionShapeCache" << std::endl;
+#endif
+
+    // anything left here is still referenced by a body that was never
+    // released, the shapes are deleted anyway as nothing else owns them
+    for (std::map<Key, Entry>::iterator it = shapes_.begin();
+        it != shapes_.end(); ++it) {
+        delete it->second.shape;
+    }
+
+    shapes_.clear();
+    keys_.clear();
+}
+
+bool CollisionShapeCache::Key::operator<(const Key& k) const {
+    if (type != k.type)
+        return type < k.type;
+
+    for (int i = 0; i < 3; ++i) {
+        if (dimensions[i] != k.dimensions[i])
+            return dimensions[i] < k.dimensions[i];
+    }
+
+    return false;
+}
+
+btCollisionShape* CollisionShapeCache::acquire_sphere(float radius) {
+    Key key;
+    key.type = SPHERE;
+    key.dimensions[0] = radius;
+    key.dimensions[1] = 0.0f;
+    key.dimensions[2] = 0.0f;
+
+    return acquire(key);
+}
+
+btCollisionShape* CollisionShapeCache::acquire_box(const btVector3& half_extents) {
+    Key key;
+    key.type = BOX;
+    key.dimensions[0] = half_extents.x();
+    key.dimensions[1] = half_extents.y();
+    key.dimensions[2] = half_extents.z();
+
+    return acquire(key);
+}
+
+btCollisionShape* CollisionShapeCache::acquire(const Key& key) {
+    std::map<Key, Entry>::iterator it = shapes_.find(key);
+
+    ++total_references_;
+
+    if (it != shapes_.end()) {
+        ++it->second.references;
+        return it->second.shape;
+    }
+
+    Entry entry;
+    entry.shape = create_shape(key);
+    entry.references = 1;
+
+    btVector3 inertia(0, 0, 0);
+    entry.shape->calculateLocalInertia(1.0f, inertia);
+    entry.unit_inertia[0] = inertia.x();
+    entry.unit_inertia[1] = inertia.y();
+    entry.unit_inertia[2] = inertia.z();
+
+    shapes_[key] = entry;
+    keys_[entry.shape] = key;
+
+    return entry.shape;
+}
+
+btCollisionShape* CollisionShapeCache::create_shape(const Key& key) {
+    switch (key.type) {
+    case BOX:
+        return new btBoxShape(btVector3(key.dimensions[0], key.dimensions[1],
+            key.dimensions[2]));
+    case SPHERE:
+    default:
+        return new btSphereShape((btScalar) key.dimensions[0]);
+    }
+}
+
+bool CollisionShapeCache::release(btCollisionShape* shape) {
+    std::map<btCollisionShape*, Key>::iterator key_it = keys_.find(shape);
+
+    if (key_it == keys_.end())
+        return false;
+
+    std::map<Key, Entry>::iterator it = shapes_.find(key_it->second);
+
+    --total_references_;
+
+    if (--it->second.references > 0)
+        return true;
+
+    delete it->second.shape;
+
+    shapes_.erase(it);
+    keys_.erase(key_it);
+
+    return true;
+}
+
+btVector3 CollisionShapeCache::local_inertia(btCollisionShape* shape, float mass) {
+    std::map<btCollisionShape*, Key>::iterator key_it = keys_.find(shape);
+
+    btVector3 inertia(0, 0, 0);
+
+    if (key_it == keys_.end()) {
+        shape->calculateLocalInertia(mass, inertia);
+        return inertia;
+    }
+
+    const Entry& entry = shapes_[key_it->second];
+
+    return btVector3(entry.unit_inertia[0], entry.unit_inertia[1],
+        entry.unit_inertia[2]) * mass;
+}
+
+}
@@ -59,4 +59,18 @@ void Color::set_color_a(const ci::ColorA& c) {
     color_interface_->set_color_a(c);
 }
 
+// what LightingColor does with glMaterial, per vertex
+void Color::begin_vertex_colors() {
+    if (mode_ != LIGHTING)
+        return;
+
+    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+    glEnable(GL_COLOR_MATERIAL);
+}
+
+void Color::end_vertex_colors() {
+    if (mode_ == LIGHTING)
+        glDisable(GL_COLOR_MATERIAL);
+}
+
 }
@@ -41,6 +41,13 @@ CurveSketcher::CurveSketcher() {
     // in fact, the resolution should represent the number of points
     // between two control points
     rendering_resolution_ = 1.0f / 300.0f;
+
+    for (float t = 0.0f; t <= 1.0f; t += rendering_resolution_)
+        rendering_params_.push_back(t);
+
+    for (float t = 0.0f; t <= 1.0f; t += 0.01f)
+        center_params_.push_back(t);
+
     line_thickness_ = 3.0f;
     line_color_ = ci::ColorA(1.0f, 0.5f, 0.25f, 0.9f);
 
@@ -56,6 +63,8 @@ CurveSketcher::~CurveSketcher() {
 
     active_point_.reset();
     current_spline_.reset();
+    rendering_sampler_.clear();
+    center_sampler_.clear();
     control_points_.clear();
 }
 
@@ -80,10 +89,14 @@ void CurveSketcher::draw() {
         ci::gl::color(line_color_);
         Renderer::set_line_width(line_thickness_);
 
+        rendering_sampler_.sample(current_spline_, rendering_params_);
+
+        const std::vector<ci::Vec3f>& points = rendering_sampler_.positions();
+
         glBegin(GL_LINE_STRIP);
 
-        for (float t = 0.0f; t <= 1.0f; t += rendering_resolution_) {
-            ci::gl::vertex(current_spline_->getPosition(t));
+        for (size_t i = 0; i < points.size(); ++i) {
+            ci::gl::vertex(points[i]);
         }
 
         glEnd();
@@ -172,15 +185,16 @@ ci::Vec3f CurveSketcher::current_spline_center() {
     if (invalid_curve())
         return ci::Vec3f::zero();
 
-    int count = 0;
+    center_sampler_.sample(current_spline_, center_params_);
+
+    const std::vector<ci::Vec3f>& points = center_sampler_.positions();
+
     ci::Vec3f sum = ci::Vec3f::zero();
 
-    for (float t = 0.0f; t <= 1.0f; t += 0.01) {
-        sum += current_spline_->getPosition(t);
-        ++count;
-    }
+    for (size_t i = 0; i < points.size(); ++i)
+        sum += points[i];
 
-    return sum / count;
+    return sum / (float) points.size();
 }
 
 // on first press check for intersection, if so, do nothing and wait for a drag
@@ -70,7 +70,8 @@ SoftSolidPtr CylinderFactory::create_soft_cylinder(std::pair<ci::Vec3f,
 
     SoftSolidPtr ptr = SolidFactory::create_soft_mesh(mesh);
 
-    Manager::instance().add_solid(ptr);
+    if (ptr)
+        Manager::instance().add_solid(ptr);
 
     return ptr;
 }
@@ -29,6 +29,7 @@
 
 #include <inc/inc_DxfSaver.h>
 #include <inc/inc_Solid.h>
+#include <inc/inc_EmbeddedMesh.h>
 
 namespace inc {
 
@@ -51,6 +52,26 @@ void DxfSaver::add_layer() {
 }
 
 void DxfSaver::input_soft_solid(SoftSolid& solid) {
+    EmbeddedMesh* embedded = solid.embedded_mesh();
+
+    if (embedded != NULL) {
+        embedded->update();
+
+        const btAlignedObjectArray<btVector3>& positions = embedded->positions();
+        const std::vector<int>& indices = embedded->indices();
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            const btVector3& a = positions[indices[i]];
+            const btVector3& b = positions[indices[i + 1]];
+            const btVector3& c = positions[indices[i + 2]];
+
+            write_triangle(a.x(), a.y(), a.z(), b.x(), b.y(), b.z(), 
+                c.x(), c.y(), c.z());
+        }
+
+        return;
+    }
+
     btSoftBody* soft_body = solid.soft_body_ptr();
     
     int num_faces = soft_body->m_faces.size();
@@ -193,14 +214,138 @@ void DxfSaver::write_trimesh_wireframe(const ci::TriMesh& mesh) {
 }
 
 
+ObjSaver::ObjSaver(const std::string& file_name) :
+    file_name_(file_name) {
+    num_vertices_ = 0;
+    current_layer_ = 0;
+}
+
+void ObjSaver::set_path(const std::string& file_name) {
+    file_name_ = file_name;
+}
+
+void ObjSaver::begin() {
+    file_.open(file_name_, std::ios::out);
+    num_vertices_ = 0;
+
+    file_ << "# INC" << std::endl;
+    write_group();
+}
+
+void ObjSaver::end() {
+    file_.close();
+}
+
+void ObjSaver::set_layer(int layer) {
+    current_layer_ = layer;
+    write_group();
+}
+
+void ObjSaver::add_layer() {
+    ++current_layer_;
+    write_group();
+}
+
+void ObjSaver::write_group() {
+    if (!file_.is_open())
+        return;
+
+    file_ << "g layer_" << current_layer_ << std::endl;
+}
+
+void ObjSaver::write_vertex(float x, float y, float z) {
+    file_ << "v " << x << " " << y << " " << z << std::endl;
+    ++num_vertices_;
+}
+
+void ObjSaver::input_soft_solid(SoftSolid& solid) {
+    btSoftBody* soft_body = solid.soft_body_ptr();
+
+    int first = num_vertices_ + 1;
+    EmbeddedMesh* embedded = solid.embedded_mesh();
+
+    if (embedded != NULL) {
+        embedded->update();
+
+        const btAlignedObjectArray<btVector3>& positions = embedded->positions();
+        const std::vector<int>& indices = embedded->indices();
+
+        for (int i = 0; i < positions.size(); ++i)
+            write_vertex(positions[i].x(), positions[i].y(), positions[i].z());
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            file_ << "f " << first + indices[i] << 
+                " " << first + indices[i + 1] << 
+                " " << first + indices[i + 2] << std::endl;
+        }
+
+        return;
+    }
+    int num_nodes = soft_body->m_nodes.size();
+
+    if (num_nodes == 0)
+        return;
+
+    for (int i = 0; i < num_nodes; ++i) {
+        const btVector3& x = soft_body->m_nodes[i].m_x;
+        write_vertex(x.x(), x.y(), x.z());
+    }
+
+    const btSoftBody::Node* base = &soft_body->m_nodes[0];
+    int num_faces = soft_body->m_faces.size();
+
+    for (int i = 0; i < num_faces; ++i) {
+        const btSoftBody::Face& face = soft_body->m_faces[i];
+
+        file_ << "f " << first + int(face.m_n[0] - base) << 
+            " " << first + int(face.m_n[1] - base) << 
+            " " << first + int(face.m_n[2] - base) << std::endl;
+    }
+}
+
+void ObjSaver::write_line(const ci::Vec3f& v1, const ci::Vec3f& v2) {
+    write_vertex(v1.x, v1.y, v1.z);
+    write_vertex(v2.x, v2.y, v2.z);
+
+    file_ << "l " << num_vertices_ - 1 << " " << num_vertices_ << std::endl;
+}
 
+void ObjSaver::write_triangle(const ci::Vec3f& v1,
+    const ci::Vec3f& v2, const ci::Vec3f& v3) {
+    write_vertex(v1.x, v1.y, v1.z);
+    write_vertex(v2.x, v2.y, v2.z);
+    write_vertex(v3.x, v3.y, v3.z);
 
+    file_ << "f " << num_vertices_ - 2 << " " << num_vertices_ - 1 << 
+        " " << num_vertices_ << std::endl;
+}
 
+void ObjSaver::write_trimesh(const ci::TriMesh& mesh) {
+    const std::vector<ci::Vec3f>& vertices = mesh.getVertices();
+    const std::vector<size_t>& indices = mesh.getIndices();
 
+    int first = num_vertices_ + 1;
 
+    for (size_t i = 0; i < vertices.size(); ++i)
+        write_vertex(vertices[i].x, vertices[i].y, vertices[i].z);
 
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        file_ << "f " << first + (int) indices[i] << 
+            " " << first + (int) indices[i + 1] << 
+            " " << first + (int) indices[i + 2] << std::endl;
+    }
+}
 
+void ObjSaver::write_trimesh_wireframe(const ci::TriMesh& mesh) {
+    ci::Vec3f a, b, c;
 
+    for (int i = 0; i < mesh.getNumTriangles(); ++i) {
+        mesh.getTriangleVertices(i, &a, &b, &c);
 
+        write_line(a, b);
+        write_line(b, c);
+        write_line(c, a);
+    }
+}
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,425 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <set>
+#include <tuple>
+
+#include <inc/inc_EmbeddedMesh.h>
+#include <inc/inc_MeshWelder.h>
+#include <inc/inc_TaskPool.h>
+
+namespace inc {
+
+// vertices per job, small enough to balance and big enough that the pool's
+// overhead doesn't show
+static const int kBlockSize = 1024;
+
+// calls fn(begin, end) over [0, count) in blocks, on the pool if there is one
+static void for_blocks(TaskPool* pool, int count, 
+    const std::function<void (int, int)>& fn) {
+    int num_blocks = (count + kBlockSize - 1) / kBlockSize;
+
+    if (pool == NULL || num_blocks < 2) {
+        fn(0, count);
+        return;
+    }
+
+    pool->parallel_for(0, num_blocks, [&] (int block) {
+        int begin = block * kBlockSize;
+        fn(begin, std::min(begin + kBlockSize, count));
+    } );
+}
+
+// the squared distance from p to the closest point of triangle abc, see
+// Ericson, Real-Time Collision Detection, 5.1.5
+static btScalar triangle_distance2(const btVector3& p, const btVector3& a,
+    const btVector3& b, const btVector3& c) {
+    btVector3 ab = b - a;
+    btVector3 ac = c - a;
+    btVector3 ap = p - a;
+
+    btScalar d1 = ab.dot(ap);
+    btScalar d2 = ac.dot(ap);
+    if (d1 <= 0 && d2 <= 0)
+        return ap.length2();
+
+    btVector3 bp = p - b;
+    btScalar d3 = ab.dot(bp);
+    btScalar d4 = ac.dot(bp);
+    if (d3 >= 0 && d4 <= d3)
+        return bp.length2();
+
+    btScalar vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+        return (ap - ab * (d1 / (d1 - d3))).length2();
+
+    btVector3 cp = p - c;
+    btScalar d5 = ab.dot(cp);
+    btScalar d6 = ac.dot(cp);
+    if (d6 >= 0 && d5 <= d6)
+        return cp.length2();
+
+    btScalar vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+        return (ap - ac * (d2 / (d2 - d6))).length2();
+
+    btScalar va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+        return (bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))).length2();
+
+    btScalar denom = 1 / (va + vb + vc);
+    btVector3 closest = a + ab * (vb * denom) + ac * (vc * denom);
+
+    return (p - closest).length2();
+}
+
+EmbeddedMesh::EmbeddedMesh(const ci::TriMesh& fine, 
+    const std::vector<int>& fine_to_cage, btSoftBody* cage, ci::Vec3f scl) 
+    : cage_(cage) {
+    outset_min_ = btVector3(0, 0, 0);
+    outset_max_ = btVector3(0, 0, 0);
+
+    const std::vector<ci::Vec3f>& vertices = fine.getVertices();
+    const std::vector<size_t>& indices = fine.getIndices();
+    int num_vertices = (int) vertices.size();
+
+    indices_.assign(indices.begin(), indices.end());
+
+    // the fine triangles around each fine vertex, for the normals
+    vertex_face_start_.assign(num_vertices + 1, 0);
+
+    for (size_t i = 0; i < indices_.size(); ++i)
+        ++vertex_face_start_[indices_[i] + 1];
+
+    for (int i = 0; i < num_vertices; ++i)
+        vertex_face_start_[i + 1] += vertex_face_start_[i];
+
+    vertex_faces_.resize(indices_.size());
+    std::vector<int> fill(vertex_face_start_.begin(), 
+        vertex_face_start_.end() - 1);
+
+    for (size_t i = 0; i < indices_.size(); ++i)
+        vertex_faces_[fill[indices_[i]]++] = (int) i / 3;
+
+    // and the cage faces around each cage node, for the search
+    int num_nodes = cage_->m_nodes.size();
+    int num_cage_faces = cage_->m_faces.size();
+    const btSoftBody::Node* base = num_nodes > 0 ? &cage_->m_nodes[0] : NULL;
+
+    std::vector<std::vector<int> > node_faces(num_nodes);
+
+    for (int i = 0; i < num_cage_faces; ++i) {
+        for (int j = 0; j < 3; ++j)
+            node_faces[cage_->m_faces[i].m_n[j] - base].push_back(i);
+    }
+
+    std::vector<int> all_faces(num_cage_faces);
+    for (int i = 0; i < num_cage_faces; ++i)
+        all_faces[i] = i;
+
+    bindings_.resize(num_vertices);
+    std::vector<int> candidates;
+
+    for (int i = 0; i < num_vertices; ++i) {
+        btVector3 p(vertices[i].x * scl.x, vertices[i].y * scl.y, 
+            vertices[i].z * scl.z);
+
+        int node = i < (int) fine_to_cage.size() ? fine_to_cage[i] : -1;
+
+        if (node < 0 || node >= num_nodes || node_faces[node].empty()) {
+            bind(i, p, all_faces);
+            continue;
+        }
+
+        // the faces around the vertex's own node, and around their nodes.
+        // Clustering keeps the vertex within a cell of its node, so the 
+        // nearest face is almost always in here
+        candidates.clear();
+
+        const std::vector<int>& ring = node_faces[node];
+
+        for (size_t j = 0; j < ring.size(); ++j) {
+            for (int k = 0; k < 3; ++k) {
+                const std::vector<int>& next = 
+                    node_faces[cage_->m_faces[ring[j]].m_n[k] - base];
+                candidates.insert(candidates.end(), next.begin(), next.end());
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()),
+            candidates.end());
+
+        bind(i, p, candidates);
+    }
+
+    update();
+}
+
+void EmbeddedMesh::bind(int vertex, const btVector3& p, 
+    const std::vector<int>& faces) {
+    Binding& binding = bindings_[vertex];
+
+    btScalar best = SIMD_INFINITY;
+    int best_face = -1;
+
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const btSoftBody::Face& face = cage_->m_faces[faces[i]];
+        const btVector3& a = face.m_n[0]->m_x;
+        const btVector3& b = face.m_n[1]->m_x;
+        const btVector3& c = face.m_n[2]->m_x;
+
+        // a sliver has no normal to measure the offset along
+        if ((b - a).cross(c - a).length2() <= SIMD_EPSILON)
+            continue;
+
+        btScalar d = triangle_distance2(p, a, b, c);
+
+        if (d < best) {
+            best = d;
+            best_face = faces[i];
+        }
+    }
+
+    if (best_face < 0) {
+        // nothing to bind to, the vertex stays where the first node goes
+        binding.node[0] = binding.node[1] = binding.node[2] = 0;
+        binding.weight[0] = 1;
+        binding.weight[1] = binding.weight[2] = 0;
+        binding.offset = 0;
+        return;
+    }
+
+    const btSoftBody::Face& face = cage_->m_faces[best_face];
+    const btSoftBody::Node* base = &cage_->m_nodes[0];
+
+    for (int i = 0; i < 3; ++i)
+        binding.node[i] = int(face.m_n[i] - base);
+
+    const btVector3& a = face.m_n[0]->m_x;
+    btVector3 ab = face.m_n[1]->m_x - a;
+    btVector3 ac = face.m_n[2]->m_x - a;
+    btVector3 normal = ab.cross(ac).normalized();
+
+    binding.offset = normal.dot(p - a);
+
+    // barycentric coordinates of p projected onto the face plane
+    btVector3 ap = p - a - normal * binding.offset;
+
+    btScalar d00 = ab.dot(ab);
+    btScalar d01 = ab.dot(ac);
+    btScalar d11 = ac.dot(ac);
+    btScalar d20 = ap.dot(ab);
+    btScalar d21 = ap.dot(ac);
+    btScalar denom = d00 * d11 - d01 * d01;
+
+    binding.weight[1] = (d11 * d20 - d01 * d21) / denom;
+    binding.weight[2] = (d00 * d21 - d01 * d20) / denom;
+    binding.weight[0] = 1 - binding.weight[1] - binding.weight[2];
+}
+
+void EmbeddedMesh::update(TaskPool* pool, 
+    const btAlignedObjectArray<btVector3>* previous, float alpha) {
+    int num_nodes = cage_->m_nodes.size();
+
+    // an empty cage still gives the unbound vertices a node 0 to sit on
+    nodes_.resize(std::max(num_nodes, 1));
+    nodes_[0] = btVector3(0, 0, 0);
+
+    for (int i = 0; i < num_nodes; ++i) {
+        if (previous == NULL)
+            nodes_[i] = cage_->m_nodes[i].m_x;
+        else
+            nodes_[i] = (*previous)[i].lerp(cage_->m_nodes[i].m_x, alpha);
+    }
+
+    deform(pool);
+}
+
+void EmbeddedMesh::update(TaskPool* pool, const btVector3* nodes) {
+    int num_nodes = cage_->m_nodes.size();
+
+    nodes_.resize(std::max(num_nodes, 1));
+    nodes_[0] = btVector3(0, 0, 0);
+
+    for (int i = 0; i < num_nodes; ++i)
+        nodes_[i] = nodes[i];
+
+    deform(pool);
+}
+
+void EmbeddedMesh::deform(TaskPool* pool) {
+    int num_vertices = (int) bindings_.size();
+    positions_.resize(num_vertices);
+
+    for_blocks(pool, num_vertices, [&] (int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const Binding& binding = bindings_[i];
+            const btVector3& a = nodes_[binding.node[0]];
+            const btVector3& b = nodes_[binding.node[1]];
+            const btVector3& c = nodes_[binding.node[2]];
+
+            btVector3 normal = (b - a).cross(c - a);
+            btScalar length = normal.length();
+
+            if (length > SIMD_EPSILON)
+                normal /= length;
+
+            positions_[i] = a * binding.weight[0] + b * binding.weight[1] +
+                c * binding.weight[2] + normal * binding.offset;
+        }
+    } );
+
+    update_outsets();
+    update_normals(pool);
+}
+
+void EmbeddedMesh::update_outsets() {
+    outset_min_ = btVector3(0, 0, 0);
+    outset_max_ = btVector3(0, 0, 0);
+
+    if (positions_.size() == 0)
+        return;
+
+    btVector3 node_min = nodes_[0];
+    btVector3 node_max = node_min;
+
+    for (int i = 1; i < nodes_.size(); ++i) {
+        node_min.setMin(nodes_[i]);
+        node_max.setMax(nodes_[i]);
+    }
+
+    btVector3 min = positions_[0];
+    btVector3 max = min;
+
+    for (int i = 1; i < positions_.size(); ++i) {
+        min.setMin(positions_[i]);
+        max.setMax(positions_[i]);
+    }
+
+    outset_min_.setMax(node_min - min);
+    outset_max_.setMax(max - node_max);
+}
+
+void EmbeddedMesh::expand_cage_bounds(btVector3& min, btVector3& max) {
+    min -= outset_min_;
+    max += outset_max_;
+}
+
+void EmbeddedMesh::update_normals(TaskPool* pool) {
+    int num_faces = num_triangles();
+    int num_vertices = (int) bindings_.size();
+
+    face_normals_.resize(num_faces);
+    normals_.resize(num_vertices);
+
+    // left unnormalised so bigger faces count for more
+    for_blocks(pool, num_faces, [&] (int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const btVector3& a = positions_[indices_[i * 3]];
+
+            face_normals_[i] = (positions_[indices_[i * 3 + 1]] - a).cross(
+                positions_[indices_[i * 3 + 2]] - a);
+        }
+    } );
+
+    // each vertex gathers its own faces, so no two threads write the same 
+    // normal
+    for_blocks(pool, num_vertices, [&] (int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            btVector3 normal(0, 0, 0);
+
+            for (int j = vertex_face_start_[i]; j < vertex_face_start_[i + 1]; 
+                ++j)
+                normal += face_normals_[vertex_faces_[j]];
+
+            btScalar length = normal.length();
+
+            normals_[i] = length > SIMD_EPSILON ? normal / length : normal;
+        }
+    } );
+}
+
+std::tr1::shared_ptr<ci::TriMesh> EmbeddedMesh::decimate(
+    const ci::TriMesh& mesh, float cell_size, std::vector<int>& fine_to_cage) {
+    const std::vector<ci::Vec3f>& vertices = mesh.getVertices();
+    const std::vector<size_t>& indices = mesh.getIndices();
+
+    MeshWelder welder(cell_size);
+    welder.reserve(vertices.size());
+
+    std::vector<int> cluster(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+        cluster[i] = welder.add(vertices[i]);
+
+    const std::vector<ci::Vec3f>& welded = welder.vertices();
+
+    // several fine triangles often land on the same cage triangle, in 
+    // either winding, only the first is kept
+    std::set<std::tr1::tuple<int, int, int> > seen;
+    std::vector<int> triangles;
+    std::vector<int> used(welded.size(), -1);
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        int tri[3] = { cluster[indices[i]], cluster[indices[i + 1]], 
+            cluster[indices[i + 2]] };
+
+        if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+            continue;
+
+        int sorted[3] = { tri[0], tri[1], tri[2] };
+        std::sort(sorted, sorted + 3);
+
+        if (!seen.insert(std::tr1::make_tuple(sorted[0], sorted[1], 
+            sorted[2])).second)
+            continue;
+
+        for (int j = 0; j < 3; ++j) {
+            triangles.push_back(tri[j]);
+            used[tri[j]] = 0;
+        }
+    }
+
+    // drop the vertices no triangle uses, Bullet would make free nodes of
+    // them
+    std::tr1::shared_ptr<ci::TriMesh> cage(new ci::TriMesh());
+
+    for (size_t i = 0; i < welded.size(); ++i) {
+        if (used[i] < 0)
+            continue;
+
+        used[i] = (int) cage->getNumVertices();
+        cage->appendVertex(welded[i]);
+    }
+
+    for (size_t i = 0; i < triangles.size(); i += 3)
+        cage->appendTriangle(used[triangles[i]], used[triangles[i + 1]], 
+            used[triangles[i + 2]]);
+
+    fine_to_cage.resize(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+        fine_to_cage[i] = used[cluster[i]];
+
+    return cage;
+}
+
+}
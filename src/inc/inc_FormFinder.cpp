@@ -0,0 +1,127 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+#include <cinder/Timer.h>
+
+#include <inc/inc_FormFinder.h>
+#include <inc/inc_Solid.h>
+#include <inc/inc_DxfSaver.h>
+
+namespace inc {
+
+FormFinder::FormFinder() {
+    time_step_ = 1.0f / 60.0f;
+    max_steps_ = 100000;
+
+    steps_ = 0;
+    seconds_ = 0.0;
+    converged_ = false;
+}
+
+bool FormFinder::run(std::shared_ptr<SoftSolid> solid) {
+    SolidFactory& factory = SolidFactory::instance();
+
+    // the settle test is the convergence test, so it can't be off
+    *factory.allow_settling_ptr() = true;
+    solid->wake();
+
+    steps_ = 0;
+    converged_ = false;
+
+    ci::Timer timer(true);
+
+    while (steps_ < max_steps_) {
+        factory.step(time_step_);
+        ++steps_;
+
+        if (solid->settled()) {
+            converged_ = true;
+            break;
+        }
+    }
+
+    timer.stop();
+    seconds_ = timer.getSeconds();
+
+    return converged_;
+}
+
+void FormFinder::save(std::shared_ptr<SoftSolid> solid,
+    const std::string& file_name) {
+    save(file_name, [solid] (Exporter& exporter) {
+        solid->save(exporter);
+    } );
+}
+
+void FormFinder::save(const ci::TriMesh& mesh, const std::string& file_name) {
+    save(file_name, [&mesh] (Exporter& exporter) {
+        exporter.write_trimesh(mesh);
+    } );
+}
+
+void FormFinder::save(const std::string& file_name, 
+    const std::function<void (Exporter&)>& write) {
+    std::string extension;
+    size_t dot = file_name.rfind('.');
+
+    if (dot != std::string::npos)
+        extension = file_name.substr(dot + 1);
+
+    std::transform(extension.begin(), extension.end(), extension.begin(), 
+        ::tolower);
+
+    if (extension == "obj") {
+        ObjSaver saver(file_name);
+
+        saver.begin();
+        write(saver);
+        saver.end();
+    } else {
+        DxfSaver saver(file_name);
+
+        saver.begin();
+        write(saver);
+        saver.end();
+    }
+}
+
+float FormFinder::steps_per_second() {
+    if (seconds_ <= 0.0)
+        return 0.0f;
+
+    return (float) (steps_ / seconds_);
+}
+
+std::string FormFinder::summary() {
+    std::stringstream ss;
+
+    ss.precision(3);
+
+    ss << (converged_ ? "settled after " : "did not settle after ") << 
+        steps_ << " steps, " << seconds_ << " s, " << 
+        steps_per_second() << " steps/sec";
+
+    return ss.str();
+}
+
+}
@@ -0,0 +1,71 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <inc/inc_Frustum.h>
+
+namespace inc {
+
+Frustum::Frustum() {
+    // until set, nothing is outside
+    for (int i = 0; i < 6; ++i)
+        planes_[i] = ci::Vec4f(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void Frustum::set(const ci::Camera& camera) {
+    set(camera.getProjectionMatrix(), camera.getModelViewMatrix());
+}
+
+// Gribb and Hartmann: each plane is the last row of the combined matrix
+// plus or minus one of the others
+void Frustum::set(const ci::Matrix44f& projection, 
+    const ci::Matrix44f& modelview) {
+    ci::Matrix44f m = projection * modelview;
+
+    ci::Vec4f rows[4];
+
+    for (int i = 0; i < 4; ++i)
+        rows[i] = ci::Vec4f(m.at(i, 0), m.at(i, 1), m.at(i, 2), m.at(i, 3));
+
+    planes_[0] = rows[3] + rows[0]; // left
+    planes_[1] = rows[3] - rows[0]; // right
+    planes_[2] = rows[3] + rows[1]; // bottom
+    planes_[3] = rows[3] - rows[1]; // top
+    planes_[4] = rows[3] + rows[2]; // near
+    planes_[5] = rows[3] - rows[2]; // far
+}
+
+bool Frustum::intersects(const ci::AxisAlignedBox3f& box) const {
+    const ci::Vec3f& min = box.getMin();
+    const ci::Vec3f& max = box.getMax();
+
+    for (int i = 0; i < 6; ++i) {
+        const ci::Vec4f& p = planes_[i];
+
+        // the corner furthest along the plane's normal
+        float x = p.x >= 0.0f ? max.x : min.x;
+        float y = p.y >= 0.0f ? max.y : min.y;
+        float z = p.z >= 0.0f ? max.z : min.z;
+
+        if (p.x * x + p.y * y + p.z * z + p.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,97 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cinder/app/App.h>
+
+#include <inc/inc_GradientShader.h>
+#include <inc/inc_Color.h>
+
+namespace inc {
+
+namespace {
+
+const char* kVertexShader =
+    "#version 110\n"
+    "uniform float min_y;\n"
+    "uniform float max_y;\n"
+    "uniform vec4 base_color;\n"
+    "uniform vec4 top_color;\n"
+    "uniform int lighting;\n"
+    "\n"
+    "void main() {\n"
+    "    float range = max_y - min_y;\n"
+    "    float t = range > 0.0 ? (gl_Vertex.y - min_y) / range : 0.0;\n"
+    "    vec4 color = clamp(mix(base_color, top_color, t), 0.0, 1.0);\n"
+    "\n"
+    "    if (lighting != 0) {\n"
+    "        vec3 n = normalize(gl_NormalMatrix * gl_Normal);\n"
+    "        vec3 l = normalize(gl_LightSource[0].position.xyz);\n"
+    "        vec3 light = gl_LightModel.ambient.rgb + \n"
+    "            gl_LightSource[0].ambient.rgb +\n"
+    "            gl_LightSource[0].diffuse.rgb * max(dot(n, l), 0.0);\n"
+    "\n"
+    "        color.rgb *= light;\n"
+    "    }\n"
+    "\n"
+    "    gl_FrontColor = color;\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+const char* kFragmentShader =
+    "#version 110\n"
+    "\n"
+    "void main() {\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n";
+
+}
+
+GradientShader::GradientShader() {
+    available_ = false;
+}
+
+bool GradientShader::setup() {
+    try {
+        program_ = ci::gl::GlslProg(kVertexShader, kFragmentShader);
+        available_ = true;
+    } catch (ci::gl::GlslProgCompileExc& e) {
+        ci::app::console() << "Gradient shader unavailable, coloring on the "
+            << "CPU: " << e.what() << std::endl;
+        available_ = false;
+    }
+
+    return available_;
+}
+
+void GradientShader::bind(float min_y, float max_y, const ci::ColorA& base,
+    const ci::ColorA& top) {
+    program_.bind();
+
+    program_.uniform("min_y", min_y);
+    program_.uniform("max_y", max_y);
+    program_.uniform("base_color", base);
+    program_.uniform("top_color", top);
+    program_.uniform("lighting", Color::color_mode() == Color::LIGHTING ? 1 : 0);
+}
+
+void GradientShader::unbind() {
+    program_.unbind();
+}
+
+}
@@ -29,6 +29,8 @@
 #include <inc/inc_Renderer.h>
 #include <inc/inc_Color.h>
 #include <inc/inc_DxfSaver.h>
+#include <inc/inc_EmbeddedMesh.h>
+#include <inc/inc_Camera.h>
 
 namespace inc {
 
@@ -69,11 +71,75 @@ void SolidGraphicItem::set_solid(Solid* s) {
 OriginGraphicItem::OriginGraphicItem() {
     grid_plane_size_ = 1000.0f;
     grid_plane_intervals_ = 30;
+    infinite_grid_ = false;
+
+    initialized_ = false;
+    lines_valid_ = false;
+    num_grid_vertices_ = 0;
 }
 
 void OriginGraphicItem::draw() {
+    // the buffer and shader are made on the first draw, when there's sure
+    // to be a context
+    if (!initialized_) {
+        lines_ = ci::gl::Vbo(GL_ARRAY_BUFFER);
+        grid_shader_.setup();
+        initialized_ = true;
+    }
+
+    if (!lines_valid_)
+        build_lines();
+
     draw_axis();
-    draw_grid_plane_lines();
+
+    if (infinite_grid_ && grid_shader_.available())
+        draw_infinite_grid();
+    else
+        draw_grid_plane_lines();
+}
+
+bool OriginGraphicItem::adjust_grid(float) {
+    lines_valid_ = false;
+
+    return false;
+}
+
+void OriginGraphicItem::build_lines() {
+    int intervals = ci::math<int>::max((int) grid_plane_intervals_, 1);
+    num_grid_vertices_ = 2 * intervals * 4;
+
+    std::vector<float> line_verts(3 * (6 + num_grid_vertices_));
+
+    line_verts[0] = -1000.0f; line_verts[1] = 0.0f; line_verts[2] = 0.0f;
+    line_verts[3] = 1000.0f; line_verts[4] = 0.0f; line_verts[5] = 0.0f; 
+    line_verts[6] = 0.0f; line_verts[7] = -1000.0f; line_verts[8] = 0.0f;
+    line_verts[9] = 0.0f; line_verts[10] = 1000.0f; line_verts[11] = 0.0f;
+    line_verts[12] = 0.0f; line_verts[13] = 0.0f; line_verts[14] = -1000.0f;
+    line_verts[15] = 0.0f; line_verts[16] = 0.0f; line_verts[17] = 1000.0f; 
+
+    float grid_step = grid_plane_size_ / intervals;
+    float x = -grid_plane_size_;
+    int index = 18;
+    for (int c = -intervals; c < intervals; ++c) {
+        line_verts[index] = x; line_verts[index+1] = 0.0f; line_verts[index+2] =  -grid_plane_size_;
+        line_verts[index+3] = x; line_verts[index+4] = 0.0f; line_verts[index+5] = grid_plane_size_;
+        index += 6;
+        x += grid_step;
+    }
+    float y = -grid_plane_size_;
+    for (int c = -intervals; c < intervals; ++c) {
+        line_verts[index] = -grid_plane_size_; line_verts[index+1] = 0.0f; line_verts[index+2] = y;
+        line_verts[index+3] = grid_plane_size_; line_verts[index+4] = 0.0f; line_verts[index+5] = y;
+        index += 6;
+        y += grid_step;
+    }
+
+    lines_.bind();
+    lines_.bufferData(line_verts.size() * sizeof(float), &line_verts[0], 
+        GL_STATIC_DRAW);
+    lines_.unbind();
+
+    lines_valid_ = true;
 }
 
 void OriginGraphicItem::draw_axis() {
@@ -84,17 +150,12 @@ void OriginGraphicItem::draw_axis() {
     glLineStipple( 10, 0xAAAA );
 #endif
 
-    float line_verts[3*6];
+    lines_.bind();
     glEnableClientState( GL_VERTEX_ARRAY );
-    glVertexPointer( 3, GL_FLOAT, 0, line_verts );
-    line_verts[0] = -1000.0f; line_verts[1] = 0.0f; line_verts[2] = 0.0f;
-    line_verts[3] = 1000.0f; line_verts[4] = 0.0f; line_verts[5] = 0.0f; 
-    line_verts[6] = 0.0f; line_verts[7] = -1000.0f; line_verts[8] = 0.0f;
-    line_verts[9] = 0.0f; line_verts[10] = 1000.0f; line_verts[11] = 0.0f;
-    line_verts[12] = 0.0f; line_verts[13] = 0.0f; line_verts[14] = -1000.0f;
-    line_verts[15] = 0.0f; line_verts[16] = 0.0f; line_verts[17] = 1000.0f; 
+    glVertexPointer( 3, GL_FLOAT, 0, 0 );
     glDrawArrays( GL_LINES, 0, 6 );
     glDisableClientState( GL_VERTEX_ARRAY );
+    lines_.unbind();
 
 #if ! defined( CINDER_GLES )
     glDisable( GL_LINE_STIPPLE );
@@ -105,33 +166,21 @@ void OriginGraphicItem::draw_grid_plane_lines() {
     glColor4f( .9019f, 0.4039f, 0.0f, 0.25f );
     Renderer::set_line_width(0.5f);
 
-    int num_lines = 2*grid_plane_intervals_*4;
-    float* line_verts = new float[3*num_lines];
-    //float line_verts[];
+    lines_.bind();
     glEnableClientState( GL_VERTEX_ARRAY );
-    glVertexPointer(3, GL_FLOAT, 0, line_verts);
-
-    float grid_step = grid_plane_size_ / grid_plane_intervals_;
-    float x = -grid_plane_size_;
-    int index = 0;
-    for (int c = -grid_plane_intervals_; c < grid_plane_intervals_; ++c) {
-        line_verts[index] = x; line_verts[index+1] = 0.0f; line_verts[index+2] =  -grid_plane_size_;
-        line_verts[index+3] = x; line_verts[index+4] = 0.0f; line_verts[index+5] = grid_plane_size_;
-        index += 6;
-        x += grid_step;
-    }
-    float y = -grid_plane_size_;
-    for (int c = -grid_plane_intervals_; c < grid_plane_intervals_; ++c) {
-        line_verts[index] = -grid_plane_size_; line_verts[index+1] = 0.0f; line_verts[index+2] = y;
-        line_verts[index+3] = grid_plane_size_; line_verts[index+4] = 0.0f; line_verts[index+5] = y;
-        index += 6;
-        y += grid_step;
-    }
-
-    glDrawArrays( GL_LINES, 0, num_lines );
+    glVertexPointer( 3, GL_FLOAT, 0, 0 );
+    glDrawArrays( GL_LINES, 6, num_grid_vertices_ );
     glDisableClientState( GL_VERTEX_ARRAY );
+    lines_.unbind();
+}
+
+void OriginGraphicItem::draw_infinite_grid() {
+    const ci::CameraPersp& cam = Camera::instance().cam().getCamera();
+    float spacing = grid_plane_size_ / 
+        ci::math<float>::max(grid_plane_intervals_, 1.0f);
 
-    delete [] line_verts;
+    grid_shader_.draw(cam.getEyePoint(), spacing, cam.getFarClip(), 
+        ci::ColorA(.9019f, 0.4039f, 0.0f, 0.25f));
 }
 
 float* OriginGraphicItem::grid_plane_size_ptr() {
@@ -209,114 +258,261 @@ ci::ColorA SoftBodyGraphicItem::face_normals_color_;
 
 SoftBodyGraphicItem::SoftBodyGraphicItem(btSoftBody* soft_body,
     ci::ColorA color) : soft_body_(soft_body), color_(color) {
+    previous_positions_ = NULL;
+    interpolation_alpha_ = 1.0f;
+    render_positions_ = NULL;
+    render_normals_ = NULL;
+    display_list_ = 0;
+    display_list_valid_ = false;
 
     last_min_y_ = get_vertex_height(0, 0);
     last_max_y_ = get_vertex_height(0, 0);
 }
 
 SoftBodyGraphicItem::~SoftBodyGraphicItem() {
+    if (display_list_ != 0)
+        glDeleteLists(display_list_, 1);
+}
+
+bool SoftBodyGraphicItem::FrozenState::operator==(const FrozenState& s) const {
+    return !(base_color != s.base_color || top_color != s.top_color ||
+        flip_normals != s.flip_normals || 
+        draw_face_normals != s.draw_face_normals || color_mode != s.color_mode);
+}
+
+SoftBodyGraphicItem::FrozenState SoftBodyGraphicItem::current_frozen_state() {
+    FrozenState state;
+
+    state.base_color = Renderer::instance().base_color();
+    state.top_color = Renderer::instance().top_color();
+    state.flip_normals = flip_normals_;
+    state.draw_face_normals = draw_face_normals_;
+    state.color_mode = (int) Color::color_mode();
+
+    return state;
+}
+
+bool SoftBodyGraphicItem::bind_render_state() {
+    const RenderState* state = SolidFactory::instance().render_state();
+
+    render_positions_ = NULL;
+    render_normals_ = NULL;
+
+    if (state == NULL)
+        return true;
+
+    const RenderState::Body* body = state->find(soft_body_);
+
+    if (body == NULL || body->num_nodes != soft_body_->m_nodes.size())
+        return false;
+
+    if (body->num_nodes == 0)
+        return true;
+
+    render_positions_ = &state->positions[body->first];
+    render_normals_ = &state->normals[body->first];
+
+    return true;
 }
 
-// theres almost certainly a better way to implement this method
 void SoftBodyGraphicItem::draw() {
-    int num_faces = soft_body_->m_faces.size();
+    if (!bind_render_state())
+        return;
 
-    glBegin(GL_TRIANGLES);
+    previous_positions_ = static_cast<SoftSolid&>(solid()).previous_positions();
+    interpolation_alpha_ = SolidFactory::instance().interpolation_alpha();
 
-    float num_verts = num_faces * 3;
-    float v = 0.0f;
+    if (!static_cast<SoftSolid&>(solid()).drawn_settled()) {
+        display_list_valid_ = false;
 
-    float r1 = Renderer::instance().base_color().r;
-    float g1 = Renderer::instance().base_color().g;
-    float b1 = Renderer::instance().base_color().b;
-    float a1 = Renderer::instance().base_color().a;
+        fill_mesh_buffer();
+        draw_triangles();
+        draw_edges();
+        draw_face_normals();
 
-    float r2 = Renderer::instance().top_color().r;
-    float g2 = Renderer::instance().top_color().g;
-    float b2 = Renderer::instance().top_color().b;
-    float a2 = Renderer::instance().top_color().a;
+        return;
+    }
 
-    float vert_height;
+    // a settled body doesn't move, so the buffer is left as it is and the
+    // face normals are recorded once and replayed
+    FrozenState state = current_frozen_state();
 
-    float curr_min_y = get_vertex_height(0, 0);
-    float curr_max_y = get_vertex_height(0, 0);
+    if (!display_list_valid_ || !(state == frozen_state_)) {
+        fill_mesh_buffer();
 
-    for (int i = 0; i < num_faces; ++i) {
-        vert_height = get_vertex_height(i, 0);
-        
-        Color::set_color_a(
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, r1, r2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, g1, g2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, b1, b2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, a1, a2) );
-        
-        make_gl_normal(i, 0);
-        make_gl_vertex(i, 0);
+        if (display_list_ == 0)
+            display_list_ = glGenLists(1);
 
-        vert_height = get_vertex_height(i, 1);
+        glNewList(display_list_, GL_COMPILE);
+        draw_face_normals();
+        glEndList();
 
-        Color::set_color_a(
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, r1, r2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, g1, g2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, b1, b2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, a1, a2) );
+        frozen_state_ = state;
+        display_list_valid_ = true;
+    }
 
-        make_gl_normal(i, 1);
-        make_gl_vertex(i, 1);
+    draw_triangles();
+    draw_edges();
+    glCallList(display_list_);
+}
 
-        vert_height = get_vertex_height(i, 2);
+ci::ColorA SoftBodyGraphicItem::height_color(float y, const ci::ColorA& base,
+    const ci::ColorA& top) {
+    if (last_max_y_ <= last_min_y_)
+        return base;
 
-        Color::set_color_a(
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, r1, r2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, g1, g2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, b1, b2),
-            ci::lmap<float>(vert_height, last_min_y_, last_max_y_, a1, a2) );
+    float t = (y - last_min_y_) / (last_max_y_ - last_min_y_);
 
-        make_gl_normal(i, 2);
-        make_gl_vertex(i, 2);
+    return base * (1.0f - t) + top * t;
+}
 
-        if (vert_height >= curr_max_y)
-            curr_max_y = vert_height;
+void SoftBodyGraphicItem::fill_mesh_buffer() {
+    EmbeddedMesh* embedded = static_cast<SoftSolid&>(solid()).embedded_mesh();
 
-        if (vert_height <= curr_min_y)
-            curr_min_y = vert_height;
+    if (embedded != NULL) {
+        fill_embedded_mesh_buffer(*embedded);
+        return;
     }
 
-    last_max_y_ = curr_max_y;
-    last_min_y_ = curr_min_y;
+    int num_faces = soft_body_->m_faces.size();
+    int num_nodes = soft_body_->m_nodes.size();
 
-    glEnd();
+    // the faces are fixed once the body is made
+    if (mesh_buffer_.num_triangle_indices() != num_faces * 3) {
+        std::vector<GLuint> indices(num_faces * 3);
 
-    ci::ColorA line_color;
+        for (int i = 0; i < num_faces; ++i) {
+            for (int j = 0; j < 3; ++j)
+                indices[i * 3 + j] = (GLuint) node_index(i, j);
+        }
 
-    if (solid().selected()) {
-        line_color = ci::ColorA(1.0f, 1.0f, 0.0f, 1.0f);
+        mesh_buffer_.set_triangles(indices);
+    }
+
+    MeshBuffer::Vertex* vertices = mesh_buffer_.map(num_nodes);
+
+    if (vertices == NULL)
+        return;
+
+    bool shaded = Renderer::instance().gradient_shader().available();
+    ci::ColorA base = Renderer::instance().base_color();
+    ci::ColorA top = Renderer::instance().top_color();
+    float normal_sign = flip_normals_ ? -1.0f : 1.0f;
+
+    btVector3 lower = position(0);
+    btVector3 upper = lower;
+
+    for (int i = 0; i < num_nodes; ++i) {
+        btVector3 p = position(i);
+
+        // without the shader the colors use the last fill's heights
+        if (shaded) {
+            vertices[i].set(p, normal(i) * normal_sign);
+        } else {
+            vertices[i].set(p, normal(i) * normal_sign, 
+                height_color(p.y(), base, top));
+        }
+
+        lower.setMin(p);
+        upper.setMax(p);
+    }
+
+    mesh_buffer_.unmap();
+
+    last_min_y_ = lower.y();
+    last_max_y_ = upper.y();
+}
+
+void SoftBodyGraphicItem::fill_embedded_mesh_buffer(EmbeddedMesh& mesh) {
+    // the pool belongs to the physics thread while it runs
+    if (render_positions_ != NULL) {
+        mesh.update(NULL, render_positions_);
     } else {
-        line_color = Renderer::instance().line_color();
+        mesh.update(&SolidFactory::instance().task_pool(), previous_positions_,
+            interpolation_alpha_);
     }
 
-    Color::set_color_a(line_color);
+    const btAlignedObjectArray<btVector3>& positions = mesh.positions();
+    const btAlignedObjectArray<btVector3>& normals = mesh.normals();
+    const std::vector<int>& indices = mesh.indices();
 
-    Renderer::set_line_width(Renderer::instance().line_thickness());
+    if (mesh_buffer_.num_triangle_indices() != (int) indices.size()) {
+        mesh_buffer_.set_triangles(
+            std::vector<GLuint>(indices.begin(), indices.end()));
+    }
 
-    glBegin(GL_LINES);
-    
-    for (int i = 0; i < num_faces; ++i) {
-        make_gl_vertex(i, 0);
-        make_gl_vertex(i, 1);
+    MeshBuffer::Vertex* vertices = mesh_buffer_.map(positions.size());
+
+    if (vertices == NULL)
+        return;
+
+    bool shaded = Renderer::instance().gradient_shader().available();
+    ci::ColorA base = Renderer::instance().base_color();
+    ci::ColorA top = Renderer::instance().top_color();
+    float normal_sign = flip_normals_ ? -1.0f : 1.0f;
 
-        make_gl_vertex(i, 1);
-        make_gl_vertex(i, 2);
+    btVector3 lower = positions[0];
+    btVector3 upper = lower;
 
-        make_gl_vertex(i, 0);
-        make_gl_vertex(i, 2);
+    for (int i = 0; i < positions.size(); ++i) {
+        const btVector3& p = positions[i];
+
+        if (shaded) {
+            vertices[i].set(p, normals[i] * normal_sign);
+        } else {
+            vertices[i].set(p, normals[i] * normal_sign, 
+                height_color(p.y(), base, top));
+        }
+
+        lower.setMin(p);
+        upper.setMax(p);
     }
 
-    glEnd();
+    mesh_buffer_.unmap();
 
+    last_min_y_ = lower.y();
+    last_max_y_ = upper.y();
+}
+
+void SoftBodyGraphicItem::draw_triangles() {
+    GradientShader& shader = Renderer::instance().gradient_shader();
+
+    if (!shader.available()) {
+        mesh_buffer_.draw_triangles();
+        return;
+    }
+
+    shader.bind(last_min_y_, last_max_y_, Renderer::instance().base_color(),
+        Renderer::instance().top_color());
+    mesh_buffer_.draw_triangles();
+    shader.unbind();
+}
+
+void SoftBodyGraphicItem::draw_edges() {
+    if (solid().selected()) {
+        Color::set_color_a(ci::ColorA(1.0f, 1.0f, 0.0f, 1.0f));
+    } else {
+        Color::set_color_a(Renderer::instance().line_color());
+    }
+
+    Renderer::set_line_width(Renderer::instance().line_thickness());
+
+    mesh_buffer_.draw_edges();
+}
+
+void SoftBodyGraphicItem::draw_face_normals() {
     if (!draw_face_normals_)
         return;
 
+    EmbeddedMesh* embedded = static_cast<SoftSolid&>(solid()).embedded_mesh();
+
+    if (embedded != NULL) {
+        draw_embedded_face_normals(*embedded);
+        return;
+    }
+
+    int num_faces = soft_body_->m_faces.size();
+
     Color::set_color_a(face_normals_color_);
 
     glBegin(GL_LINES);
@@ -325,7 +521,7 @@ void SoftBodyGraphicItem::draw() {
     ci::Vec3f face_center;
 
     for (int i = 0; i < num_faces; ++i) {
-        normal_vec = soft_body_->m_faces[i].m_normal;
+        normal_vec = face_normal(i);
         face_center = get_face_center(i);
         
         glVertex3f(face_center);
@@ -341,24 +537,54 @@ void SoftBodyGraphicItem::draw() {
     glEnd();
 }
 
+void SoftBodyGraphicItem::draw_embedded_face_normals(EmbeddedMesh& mesh) {
+    // as of the last fill_embedded_mesh_buffer
+    const btAlignedObjectArray<btVector3>& positions = mesh.positions();
+    const std::vector<int>& indices = mesh.indices();
+
+    float normal_sign = flip_normals_ ? -1.0f : 1.0f;
+
+    Color::set_color_a(face_normals_color_);
+
+    glBegin(GL_LINES);
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const btVector3& a = positions[indices[i]];
+        const btVector3& b = positions[indices[i + 1]];
+        const btVector3& c = positions[indices[i + 2]];
+
+        btVector3 center = (a + b + c) / 3.0f;
+        btVector3 normal = (b - a).cross(c - a).normalized() * 
+            normal_sign * face_normals_length_;
+
+        glVertex3f(center.x(), center.y(), center.z());
+        glVertex3f(center.x() + normal.x(), center.y() + normal.y(), 
+            center.z() + normal.z());
+    }
+
+    glEnd();
+}
+
 bool SoftBodyGraphicItem::detect_selection(ci::Ray r) {
     int num_faces = soft_body_->m_faces.size();
 
     ci::Vec3f v1, v2, v3;
     float dist;
 
-    for (int i = 0; i < num_faces; ++i) {
-        v1 = ci::Vec3f(soft_body_->m_faces[i].m_n[0]->m_x.x(),
-            soft_body_->m_faces[i].m_n[0]->m_x.y(),
-            soft_body_->m_faces[i].m_n[0]->m_x.z());
+    if (!bind_render_state())
+        return false;
+
+    // interpolation is only for drawing
+    previous_positions_ = NULL;
 
-        v2 = ci::Vec3f(soft_body_->m_faces[i].m_n[1]->m_x.x(),
-            soft_body_->m_faces[i].m_n[1]->m_x.y(),
-            soft_body_->m_faces[i].m_n[1]->m_x.z());
+    for (int i = 0; i < num_faces; ++i) {
+        btVector3 p1 = node_position(i, 0);
+        btVector3 p2 = node_position(i, 1);
+        btVector3 p3 = node_position(i, 2);
 
-        v3 = ci::Vec3f(soft_body_->m_faces[i].m_n[2]->m_x.x(),
-            soft_body_->m_faces[i].m_n[2]->m_x.y(),
-            soft_body_->m_faces[i].m_n[2]->m_x.z());
+        v1 = ci::Vec3f(p1.x(), p1.y(), p1.z());
+        v2 = ci::Vec3f(p2.x(), p2.y(), p2.z());
+        v3 = ci::Vec3f(p3.x(), p3.y(), p3.z());
 
         if (r.calcTriangleIntersection(v1, v2, v3, &dist))
             return true;
@@ -368,12 +594,13 @@ bool SoftBodyGraphicItem::detect_selection(ci::Ray r) {
 }
 
 
-ShadedMesh::ShadedMesh(const ci::TriMesh& mesh) {
+ShadedMesh::ShadedMesh(const ci::TriMesh& mesh) : buffer_(GL_STATIC_DRAW) {
     mesh_ = ci::TriMesh(mesh);
     init();
 }
 
-ShadedMesh::ShadedMesh(std::shared_ptr<ci::TriMesh> mesh) {
+ShadedMesh::ShadedMesh(std::shared_ptr<ci::TriMesh> mesh) : 
+    buffer_(GL_STATIC_DRAW) {
     mesh_ = ci::TriMesh(*(mesh.get()));
     init();
 }
@@ -385,24 +612,45 @@ void ShadedMesh::init() {
 
     color_ = ci::ColorA(0.65f, 0.65f, 0.65f, 0.9);
 
-    if (shade_ && !draw_wireframe_)
-        build_normals();
+    buffer_valid_ = false;
+
+    build_normals();
+
+    bounds_ = mesh_.calcBoundingBox();
 }
 
+// smooth, unless the mesh came with its own. Vertices that were split 
+// along hard edges keep them
 void ShadedMesh::build_normals() {
-    ci::Vec3f d1, d2, center;
+    const std::vector<ci::Vec3f>& vertices = mesh_.getVertices();
 
-    normals_.clear();
+    if (mesh_.getNormals().size() == vertices.size()) {
+        normals_ = mesh_.getNormals();
+        return;
+    }
 
-    for (int i = 0; i < mesh_.getNumTriangles(); ++i) {
-        mesh_.getTriangleVertices(i, &a_, &b_, &c_);
-        
-        d1 = a_ - b_;
-        d2 = a_ - c_;
+    const std::vector<size_t>& indices = mesh_.getIndices();
+
+    normals_.assign(vertices.size(), ci::Vec3f::zero());
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const ci::Vec3f& a = vertices[indices[i]];
+        const ci::Vec3f& b = vertices[indices[i + 1]];
+        const ci::Vec3f& c = vertices[indices[i + 2]];
+
+        // its length is twice the area, so larger faces count for more
+        ci::Vec3f n = (b - a).cross(c - a);
 
-        center = (a_ + b_ + c_) / 3.0f;
+        normals_[indices[i]] += n;
+        normals_[indices[i + 1]] += n;
+        normals_[indices[i + 2]] += n;
+    }
+
+    for (size_t i = 0; i < normals_.size(); ++i) {
+        float length = normals_[i].length();
 
-        normals_.push_back(d1.cross(d2).normalized() + center);
+        if (length > 0.0f)
+            normals_[i] /= length;
     }
 }
 
@@ -410,38 +658,66 @@ void ShadedMesh::flip() {
     std::for_each(normals_.begin(), normals_.end(), [] (ci::Vec3f& v) {
         v *= -1.0f;
     } );
+
+    buffer_valid_ = false;
 }
 
 void ShadedMesh::set_color(const ci::ColorA& c) {
     color_ = c;
+    buffer_valid_ = false;
 }
 
-void ShadedMesh::draw() {
-    Color::set_color_a(color_);
+void ShadedMesh::fill_buffer() {
+    const std::vector<ci::Vec3f>& vertices = mesh_.getVertices();
+    const std::vector<size_t>& indices = mesh_.getIndices();
 
-    if (draw_wireframe_)
-        glBegin(GL_LINES);
-    else
-        glBegin(GL_TRIANGLES);
+    if (buffer_.num_triangle_indices() != (int) indices.size())
+        buffer_.set_triangles(std::vector<GLuint>(indices.begin(), indices.end()));
 
-    for (int i = 0; i < mesh_.getNumTriangles(); ++i) {
-        if (shade_ && !draw_wireframe_)
-            glNormal3f(normals_[i]);
+    MeshBuffer::Vertex* buffer_vertices = buffer_.map((int) vertices.size());
 
-        mesh_.getTriangleVertices(i, &a_, &b_, &c_);
+    if (buffer_vertices != NULL) {
+        for (size_t i = 0; i < vertices.size(); ++i)
+            buffer_vertices[i].set(vertices[i], normals_[i], color_);
 
-        if (draw_wireframe_) {
-            glVertex3f(a_); glVertex3f(b_);
-            glVertex3f(b_); glVertex3f(c_);
-            glVertex3f(c_); glVertex3f(a_);
-        } else {
-            glVertex3f(a_);
-            glVertex3f(b_);
-            glVertex3f(c_);
-        }
+        buffer_.unmap();
     }
 
-    glEnd();
+    buffer_valid_ = true;
+}
+
+void ShadedMesh::draw() {
+    // uploaded on the first draw, when there's sure to be a context, and 
+    // again after flip() or set_color()
+    if (!buffer_valid_)
+        fill_buffer();
+
+    if (draw_wireframe_) {
+        Color::set_color_a(color_);
+        buffer_.draw_edges();
+        return;
+    }
+
+    if (shade_) {
+        buffer_.draw_triangles();
+        return;
+    }
+
+    glPushAttrib(GL_ENABLE_BIT);
+    glDisable(GL_LIGHTING);
+
+    buffer_.draw_triangles();
+
+    glPopAttrib();
+}
+
+bool ShadedMesh::bounds(ci::AxisAlignedBox3f& box) {
+    if (mesh_.getNumVertices() == 0)
+        return false;
+
+    box = bounds_;
+
+    return true;
 }
 
 void ShadedMesh::save(Exporter& exporter) {
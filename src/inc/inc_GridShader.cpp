@@ -0,0 +1,113 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cinder/app/App.h>
+
+#include <inc/inc_GridShader.h>
+
+namespace inc {
+
+namespace {
+
+// the unit square is scaled by extent and moved under the eye
+const char* kVertexShader =
+    "#version 110\n"
+    "uniform vec3 eye;\n"
+    "uniform float extent;\n"
+    "varying vec2 plane;\n"
+    "\n"
+    "void main() {\n"
+    "    plane = gl_Vertex.xz * extent + eye.xz;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * \n"
+    "        vec4(plane.x, 0.0, plane.y, 1.0);\n"
+    "}\n";
+
+const char* kFragmentShader =
+    "#version 110\n"
+    "uniform vec3 eye;\n"
+    "uniform float spacing;\n"
+    "uniform float fade_distance;\n"
+    "uniform vec4 color;\n"
+    "varying vec2 plane;\n"
+    "\n"
+    "void main() {\n"
+    "    vec2 cell = plane / spacing;\n"
+    "    // how many pixels away the nearest line is, on each axis\n"
+    "    vec2 pixels = abs(fract(cell - 0.5) - 0.5) / fwidth(cell);\n"
+    "    float line = 1.0 - min(min(pixels.x, pixels.y), 1.0);\n"
+    "    float fade = 1.0 - min(distance(plane, eye.xz) / fade_distance, 1.0);\n"
+    "    float alpha = color.a * line * fade;\n"
+    "\n"
+    "    if (alpha <= 0.0)\n"
+    "        discard;\n"
+    "\n"
+    "    gl_FragColor = vec4(color.rgb, alpha);\n"
+    "}\n";
+
+}
+
+GridShader::GridShader() {
+    available_ = false;
+}
+
+bool GridShader::setup() {
+    try {
+        program_ = ci::gl::GlslProg(kVertexShader, kFragmentShader);
+        available_ = true;
+    } catch (ci::gl::GlslProgCompileExc& e) {
+        ci::app::console() << "Grid shader unavailable, drawing the grid "
+            << "as lines: " << e.what() << std::endl;
+        available_ = false;
+    }
+
+    return available_;
+}
+
+void GridShader::draw(const ci::Vec3f& eye, float spacing, 
+    float fade_distance, const ci::ColorA& color) {
+    static const float square[3 * 4] = {
+        -1.0f, 0.0f, -1.0f,
+        1.0f, 0.0f, -1.0f,
+        1.0f, 0.0f, 1.0f,
+        -1.0f, 0.0f, 1.0f
+    };
+
+    program_.bind();
+
+    program_.uniform("eye", eye);
+    program_.uniform("extent", fade_distance);
+    program_.uniform("spacing", spacing);
+    program_.uniform("fade_distance", fade_distance);
+    program_.uniform("color", color);
+
+    // the faded out parts shouldn't hide anything drawn after
+    glPushAttrib(GL_DEPTH_BUFFER_BIT);
+    glDepthMask(GL_FALSE);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, square);
+    glDrawArrays(GL_QUADS, 0, 4);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glPopAttrib();
+
+    program_.unbind();
+}
+
+}
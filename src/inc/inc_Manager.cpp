@@ -94,6 +94,8 @@ void Manager::remove_module(std::tr1::shared_ptr<Module> module) {
 }
 
 void Manager::remove_solid(SolidPtr ptr) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     for (SolidList::iterator it = solids_.begin(); it != solids_.end(); ++it) {
         if (ptr == *it) {
             solids_.erase(it, it + 1);
@@ -103,6 +105,8 @@ void Manager::remove_solid(SolidPtr ptr) {
 }
 
 void Manager::add_solid(SolidPtr ptr) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     solids_.push_back(ptr);
 }
 
@@ -124,7 +128,11 @@ void Manager::clear_module_list() {
     modules_.clear();
 }
 
+// the physics thread walks the solid list when it checks for settling, so
+// it's only changed while the thread is paused
 void Manager::clear_solid_list() {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     selectable_.clear();
     solids_.clear();
 }
@@ -43,6 +43,7 @@
 #include <inc/inc_Origin.h>
 #include <inc/inc_MeshNetwork.h>
 #include <inc/inc_CylinderFactory.h>
+#include <inc/inc_Benchmark.h>
 #include <inc/inc_Color.h>
 
 namespace inc {
@@ -102,6 +103,78 @@ void MainMenu::setup() {
 
     add_widget(reset_scene);
 
+    std::tr1::shared_ptr<GenericWidget<bool> > save_state = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Save state"));
+
+    save_state->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::save_snapshot_button), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(save_state);
+
+    // puts every body back where it was at the last save, as long as 
+    // nothing has been added or removed since
+    std::tr1::shared_ptr<GenericWidget<bool> > restore_state = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Restore state"));
+
+    restore_state->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::restore_snapshot_button), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(restore_state);
+
+    // every soft body's nodes after each step, to recording name.increc
+    std::tr1::shared_ptr<GenericWidget<bool> > record = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Record simulation",
+        SolidFactory::instance().recording_ptr()));
+
+    record->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_recording), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(record);
+
+    std::tr1::shared_ptr<GenericWidget<std::string> > recording_name = 
+        std::tr1::shared_ptr<GenericWidget<std::string> >(
+        new GenericWidget<std::string>(*this, "Recording name",
+        SolidFactory::instance().recording_name_ptr()));
+
+    add_widget(recording_name);
+
+    // shows the recorded steps in place of simulating, on the scene the 
+    // recording was made from
+    std::tr1::shared_ptr<GenericWidget<bool> > replay = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Replay recording",
+        SolidFactory::instance().replaying_ptr()));
+
+    replay->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_replaying), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(replay);
+
+    std::tr1::shared_ptr<GenericWidget<int> > replay_step = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Replay step",
+        SolidFactory::instance().replay_step_ptr(), "min=0 step=1"));
+
+    replay_step->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_replay_step), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(replay_step);
+
+    std::tr1::shared_ptr<GenericWidget<int> > replay_num_steps = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Recorded steps",
+        SolidFactory::instance().replay_num_steps_ptr(), "readonly=true"));
+
+    add_widget(replay_num_steps);
+
     std::tr1::shared_ptr<GenericWidget<bool>> debug_draw = 
         std::tr1::shared_ptr<GenericWidget<bool>>(
         new GenericWidget<bool>(*this, "Draw physics debugging",
@@ -109,6 +182,38 @@ void MainMenu::setup() {
 
     add_widget(debug_draw);
 
+    // at most this many lines a frame, and only every nth line
+    std::tr1::shared_ptr<GenericWidget<int> > debug_max_lines = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Debug line limit",
+        SolidFactory::instance().debug_draw().max_lines_ptr(), 
+        "min=0 step=1000"));
+
+    add_widget(debug_max_lines);
+
+    std::tr1::shared_ptr<GenericWidget<int> > debug_decimation = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Debug line decimation",
+        SolidFactory::instance().debug_draw().decimation_ptr(), "min=1"));
+
+    add_widget(debug_decimation);
+
+    std::tr1::shared_ptr<GenericWidget<int> > debug_lines = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Debug lines drawn",
+        SolidFactory::instance().debug_draw().lines_drawn_ptr(), 
+        "readonly=true"));
+
+    add_widget(debug_lines);
+
+    std::tr1::shared_ptr<GenericWidget<int> > debug_dropped = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Debug lines over limit",
+        SolidFactory::instance().debug_draw().lines_dropped_ptr(), 
+        "readonly=true"));
+
+    add_widget(debug_dropped);
+
     // this calls setup() on the widgets and adds them to the tweek bar
     Menu::setup();
 }
@@ -190,6 +295,29 @@ void MeshMenu::setup() {
         SolidFactory::instance_ptr()));
 
     add_widget(kMT);
+
+    // no callback, it's used the next time a mesh is made
+    std::tr1::shared_ptr<GenericWidget<float> > weld_tolerance = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Weld tolerance",
+        SolidFactory::instance().weld_tolerance_ptr(), "step=0.001 min=0"));
+
+    add_widget(weld_tolerance);
+
+    // also only used by the next mesh
+    std::tr1::shared_ptr<GenericWidget<bool> > simulate_cage = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Simulate coarse cage",
+        SolidFactory::instance().simulate_cage_ptr()));
+
+    add_widget(simulate_cage);
+
+    std::tr1::shared_ptr<GenericWidget<int> > cage_resolution = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Cage resolution",
+        SolidFactory::instance().cage_resolution_ptr(), "min=1 max=200"));
+
+    add_widget(cage_resolution);
     
 
     Menu::setup();
@@ -240,6 +368,250 @@ void SolidMenu::setup() {
 
     add_widget(set_gravity_button);
 
+    std::tr1::shared_ptr<GenericWidget<int> > step_mode = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Step mode (frame, fixed, adaptive)",
+        SolidFactory::instance().step_mode_ptr(), "min=0 max=2"));
+
+    step_mode->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_step_mode), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(step_mode);
+
+    std::tr1::shared_ptr<GenericWidget<float> > fixed_time_step = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Physics time step",
+        SolidFactory::instance().fixed_time_step_ptr(), 
+        "step=0.001 min=0.001 max=0.1"));
+
+    add_widget(fixed_time_step);
+
+    std::tr1::shared_ptr<GenericWidget<int> > max_sub_steps = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Max steps per frame",
+        SolidFactory::instance().max_sub_steps_ptr(), "min=1 max=100"));
+
+    add_widget(max_sub_steps);
+
+    std::tr1::shared_ptr<GenericWidget<float> > time_scale = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Time scale",
+        SolidFactory::instance().time_scale_ptr(), "step=0.1 min=0"));
+
+    add_widget(time_scale);
+
+    std::tr1::shared_ptr<GenericWidget<float> > physics_budget = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Physics budget (ms)",
+        SolidFactory::instance().physics_budget_ptr(), "step=0.5 min=1"));
+
+    add_widget(physics_budget);
+
+    std::tr1::shared_ptr<GenericWidget<int> > last_sub_steps = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Steps last frame",
+        SolidFactory::instance().last_sub_steps_ptr(), "readonly=true"));
+
+    add_widget(last_sub_steps);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > threaded = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Physics on its own thread",
+        SolidFactory::instance().threaded_ptr()));
+
+    threaded->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_threaded), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(threaded);
+
+    std::tr1::shared_ptr<GenericWidget<float> > physics_steps_per_second = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Physics steps/sec",
+        SolidFactory::instance().physics_steps_per_second_ptr(), 
+        "readonly=true"));
+
+    add_widget(physics_steps_per_second);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > parallel_soft_bodies = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Parallel soft bodies",
+        SolidFactory::instance().parallel_soft_bodies_ptr()));
+
+    parallel_soft_bodies->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_parallel_soft_bodies), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(parallel_soft_bodies);
+
+    std::tr1::shared_ptr<GenericWidget<int> > soft_collision_mode = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, 
+        "Soft collision (auto, vertex-face, clusters, hashed)",
+        SolidFactory::instance().soft_collision_mode_ptr(), "min=0 max=3"));
+
+    add_widget(soft_collision_mode);
+
+    std::tr1::shared_ptr<GenericWidget<int> > auto_hash_nodes = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Auto hashes above nodes",
+        SolidFactory::instance().auto_hash_nodes_ptr(), "min=0 step=8"));
+
+    add_widget(auto_hash_nodes);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > apply_soft_collision = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Set selected soft collision"));
+
+    apply_soft_collision->value_changed().registerCb(
+        std::bind1st(std::mem_fun(
+        &inc::SolidFactory::apply_soft_collision_button), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(apply_soft_collision);
+
+    std::tr1::shared_ptr<GenericWidget<int> > num_threads = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Physics threads",
+        SolidFactory::instance().num_threads_ptr(), "min=1 max=64"));
+
+    num_threads->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_num_threads), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(num_threads);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > deterministic = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Deterministic threading",
+        SolidFactory::instance().deterministic_ptr()));
+
+    deterministic->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_deterministic), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(deterministic);
+
+    std::tr1::shared_ptr<GenericWidget<int> > broadphase_type = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Broadphase (sweep, tree, auto)",
+        SolidFactory::instance().broadphase_type_ptr(), "min=0 max=2"));
+
+    broadphase_type->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_broadphase_type), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(broadphase_type);
+
+    std::tr1::shared_ptr<GenericWidget<float> > world_size = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Sweep world size",
+        SolidFactory::instance().world_size_ptr(), "step=10 min=10"));
+
+    world_size->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_world_size), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(world_size);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > rebuild_broadphase = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Rebuild broadphase"));
+
+    rebuild_broadphase->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::rebuild_broadphase_button), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(rebuild_broadphase);
+
+    std::tr1::shared_ptr<GenericWidget<int> > broadphase_pairs = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Broadphase pairs",
+        SolidFactory::instance().broadphase_pairs_ptr(), "readonly=true"));
+
+    add_widget(broadphase_pairs);
+
+    std::tr1::shared_ptr<GenericWidget<int> > manifolds = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Contact manifolds",
+        SolidFactory::instance().manifolds_ptr(), "readonly=true"));
+
+    add_widget(manifolds);
+
+    std::tr1::shared_ptr<GenericWidget<int> > objects_outside = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Outside broadphase",
+        SolidFactory::instance().objects_outside_ptr(), "readonly=true"));
+
+    add_widget(objects_outside);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > allow_settling = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Allow settling",
+        SolidFactory::instance().allow_settling_ptr()));
+
+    allow_settling->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_allow_settling), 
+        SolidFactory::instance_ptr()));
+
+    add_widget(allow_settling);
+
+    std::tr1::shared_ptr<GenericWidget<float> > settle_energy = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Settle energy",
+        SolidFactory::instance().settle_energy_ptr(), "step=0.0001 min=0"));
+
+    add_widget(settle_energy);
+
+    std::tr1::shared_ptr<GenericWidget<float> > settle_time = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Settle time (s)",
+        SolidFactory::instance().settle_time_ptr(), "step=0.1 min=0"));
+
+    add_widget(settle_time);
+
+    std::tr1::shared_ptr<GenericWidget<int> > num_settled = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Settled solids",
+        SolidFactory::instance().num_settled_ptr(), "readonly=true"));
+
+    add_widget(num_settled);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > run_benchmark = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Run soft body benchmark"));
+
+    run_benchmark->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidMenu::run_benchmark), 
+        this));
+
+    add_widget(run_benchmark);
+
+    std::tr1::shared_ptr<GenericWidget<std::string> > benchmark_results = 
+        std::tr1::shared_ptr<GenericWidget<std::string> >(
+        new GenericWidget<std::string>(*this, "Steps/sec by threads",
+        &benchmark_results_, "readonly=true"));
+
+    add_widget(benchmark_results);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > run_collision_benchmark = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Run soft collision benchmark"));
+
+    run_collision_benchmark->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidMenu::run_collision_benchmark), 
+        this));
+
+    add_widget(run_collision_benchmark);
+
+    std::tr1::shared_ptr<GenericWidget<std::string> > collision_results = 
+        std::tr1::shared_ptr<GenericWidget<std::string> >(
+        new GenericWidget<std::string>(*this, "Steps/sec by collision",
+        &collision_benchmark_results_, "readonly=true"));
+
+    add_widget(collision_results);
+
     std::tr1::shared_ptr<GenericWidget<float> > sphere_radius_button = 
         std::tr1::shared_ptr<GenericWidget<float> >(
         new GenericWidget<float>(*this, "New sphere radius",
@@ -324,6 +696,10 @@ void SolidMenu::setup() {
         new GenericWidget<float>(*this, "Linear stiffness coefficient", 
         SolidFactory::instance().sphere_kLST_ptr(), "step=0.01 min=0 max=1"));
 
+    sphere_kLST->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_sphere_kLST), 
+        SolidFactory::instance_ptr()));
+
     add_widget(sphere_kLST);
 
     std::tr1::shared_ptr<GenericWidget<float> > sphere_kVST = 
@@ -331,6 +707,10 @@ void SolidMenu::setup() {
         new GenericWidget<float>(*this, "Volume stiffness coefficient", 
         SolidFactory::instance().sphere_kVST_ptr(), "step=0.01 min=0 max=1"));
 
+    sphere_kVST->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_sphere_kVST), 
+        SolidFactory::instance_ptr()));
+
     add_widget(sphere_kVST);
 
     std::tr1::shared_ptr<GenericWidget<float> > sphere_kDF = 
@@ -338,6 +718,10 @@ void SolidMenu::setup() {
         new GenericWidget<float>(*this, "Dynamic friction coefficient", 
         SolidFactory::instance().sphere_kDF_ptr(), "step=0.01 min=0 max=1"));
 
+    sphere_kDF->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_sphere_kDF), 
+        SolidFactory::instance_ptr()));
+
     add_widget(sphere_kDF);
 
     std::tr1::shared_ptr<GenericWidget<float> > sphere_kDP = 
@@ -345,6 +729,10 @@ void SolidMenu::setup() {
         new GenericWidget<float>(*this, "Damping coefficient", 
         SolidFactory::instance().sphere_kDP_ptr(), "step=0.01 min=0 max=1"));
 
+    sphere_kDP->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_sphere_kDP), 
+        SolidFactory::instance_ptr()));
+
     add_widget(sphere_kDP);
 
     std::tr1::shared_ptr<GenericWidget<float> > sphere_kPR = 
@@ -352,6 +740,10 @@ void SolidMenu::setup() {
         new GenericWidget<float>(*this, "Pressure coefficient", 
         SolidFactory::instance().sphere_kPR_ptr(), "step=1"));
 
+    sphere_kPR->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_sphere_kPR), 
+        SolidFactory::instance_ptr()));
+
     add_widget(sphere_kPR);
 
     std::tr1::shared_ptr<GenericWidget<float> > sphere_total_mass = 
@@ -359,6 +751,10 @@ void SolidMenu::setup() {
         new GenericWidget<float>(*this, "Sphere total mass", 
         SolidFactory::instance().sphere_total_mass_ptr(), "step=0.1 min=0.1"));
 
+    sphere_total_mass->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::SolidFactory::adjust_sphere_total_mass), 
+        SolidFactory::instance_ptr()));
+
     add_widget(sphere_total_mass);
 
     std::tr1::shared_ptr<GenericWidget<bool> > allow_selection = 
@@ -385,6 +781,26 @@ bool SolidMenu::set_gravity(float grav) {
     return false;
 }
 
+bool SolidMenu::run_benchmark(bool) {
+    SoftBodyBenchmark benchmark;
+
+    benchmark.run();
+
+    benchmark_results_ = benchmark.summary();
+
+    return false;
+}
+
+bool SolidMenu::run_collision_benchmark(bool) {
+    SoftBodyBenchmark benchmark;
+
+    benchmark.run_collision_modes();
+
+    collision_benchmark_results_ = benchmark.collision_summary();
+
+    return false;
+}
+
 bool SolidMenu::create_rigid_sphere(bool) {
     ci::Vec3f pos = SolidCreator::instance().creation_point();
 
@@ -764,6 +1180,37 @@ void DisplayMenu::setup() {
 
     add_widget(grid);
 
+    std::tr1::shared_ptr<GenericWidget<float> > grid_size = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Grid size",
+        Origin::instance().graphic_item().grid_plane_size_ptr(), 
+        "min=1.0 step=10.0"));
+
+    grid_size->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::OriginGraphicItem::adjust_grid), 
+        &Origin::instance().graphic_item()));
+
+    add_widget(grid_size);
+
+    std::tr1::shared_ptr<GenericWidget<float> > grid_intervals = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Grid intervals",
+        Origin::instance().graphic_item().grid_plane_intervals_ptr(), 
+        "min=1.0 step=1.0"));
+
+    grid_intervals->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::OriginGraphicItem::adjust_grid), 
+        &Origin::instance().graphic_item()));
+
+    add_widget(grid_intervals);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > infinite_grid = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Infinite grid",
+        Origin::instance().graphic_item().infinite_grid_ptr()));
+
+    add_widget(infinite_grid);
+
     std::tr1::shared_ptr<GenericWidget<bool> > draw_normals = 
         std::tr1::shared_ptr<GenericWidget<bool> >(
         new GenericWidget<bool>(*this, "Draw face normals",
@@ -786,6 +1233,85 @@ void DisplayMenu::setup() {
 
     add_widget(normal_color);
 
+    std::tr1::shared_ptr<GenericWidget<bool> > culling = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Frustum culling",
+        Renderer::instance().frustum_culling_ptr()));
+
+    add_widget(culling);
+
+    std::tr1::shared_ptr<GenericWidget<int> > num_drawn = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Objects drawn",
+        Renderer::instance().num_drawn_ptr(), "readonly=true"));
+
+    add_widget(num_drawn);
+
+    std::tr1::shared_ptr<GenericWidget<int> > num_culled = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Objects culled",
+        Renderer::instance().num_culled_ptr(), "readonly=true"));
+
+    add_widget(num_culled);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > profile = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Profile physics",
+        SolidFactory::instance().profiler().enabled_ptr()));
+
+    add_widget(profile);
+
+    std::tr1::shared_ptr<GenericWidget<float> > frame_ms = 
+        std::tr1::shared_ptr<GenericWidget<float> >(
+        new GenericWidget<float>(*this, "Physics frame (ms)",
+        SolidFactory::instance().profiler().frame_ms_ptr(), "readonly=true"));
+
+    add_widget(frame_ms);
+
+    std::tr1::shared_ptr<GenericWidget<std::string> > sections = 
+        std::tr1::shared_ptr<GenericWidget<std::string> >(
+        new GenericWidget<std::string>(*this, "Physics sections (ms)",
+        SolidFactory::instance().profiler().sections_ptr(), "readonly=true"));
+
+    add_widget(sections);
+
+    std::tr1::shared_ptr<GenericWidget<std::string> > bullet_sections = 
+        std::tr1::shared_ptr<GenericWidget<std::string> >(
+        new GenericWidget<std::string>(*this, "Slowest Bullet sections (ms)",
+        SolidFactory::instance().profiler().bullet_sections_ptr(), 
+        "readonly=true"));
+
+    add_widget(bullet_sections);
+
+    std::tr1::shared_ptr<GenericWidget<std::string> > largest_soft_body = 
+        std::tr1::shared_ptr<GenericWidget<std::string> >(
+        new GenericWidget<std::string>(*this, "Largest soft body",
+        SolidFactory::instance().profiler().largest_soft_body_ptr(), 
+        "readonly=true"));
+
+    add_widget(largest_soft_body);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > log_profile = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Log profile every frame",
+        SolidFactory::instance().profiler().log_ptr()));
+
+    add_widget(log_profile);
+
+    std::tr1::shared_ptr<GenericWidget<int> > log_format = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Profile log format (csv, json)",
+        SolidFactory::instance().profiler().log_format_ptr(), "min=0 max=1"));
+
+    add_widget(log_format);
+
+    std::tr1::shared_ptr<GenericWidget<std::string> > log_name = 
+        std::tr1::shared_ptr<GenericWidget<std::string> >(
+        new GenericWidget<std::string>(*this, "Profile log name",
+        SolidFactory::instance().profiler().log_name_ptr()));
+
+    add_widget(log_name);
+
     Menu::setup();
 }
 
@@ -803,6 +1329,8 @@ FileMenu::FileMenu() {
     high_res_image_width_ = 5000;
     file_name_ = "mosball_";
     save_uuid_ = true;
+    replay_stride_ = 1;
+    replay_dxf_ = false;
 }
 
 void FileMenu::setup() {
@@ -855,6 +1383,30 @@ void FileMenu::setup() {
 
     add_widget(save_uuid);
 
+    // an image of every replay_stride_ th step of the replay, and a DXF 
+    // too if replay_dxf_ is set
+    std::tr1::shared_ptr<GenericWidget<bool> > save_replay = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Save replay frames"));
+
+    save_replay->value_changed().registerCb(
+        std::bind1st(std::mem_fun(&inc::FileMenu::save_replay), this));
+
+    add_widget(save_replay);
+
+    std::tr1::shared_ptr<GenericWidget<int> > replay_stride = 
+        std::tr1::shared_ptr<GenericWidget<int> >(
+        new GenericWidget<int>(*this, "Replay frame stride", 
+        &replay_stride_, "min=1 step=1"));
+
+    add_widget(replay_stride);
+
+    std::tr1::shared_ptr<GenericWidget<bool> > replay_dxf = 
+        std::tr1::shared_ptr<GenericWidget<bool> >(
+        new GenericWidget<bool>(*this, "Save replay DXFs", &replay_dxf_));
+
+    add_widget(replay_dxf);
+
     Menu::setup();
 }
 
@@ -894,7 +1446,40 @@ std::string FileMenu::get_file_name() {
 }
 
 bool FileMenu::save_dxf(bool) {
-    DxfSaver saver = DxfSaver(get_file_name() + ".dxf");
+    write_dxf(get_file_name() + ".dxf");
+
+    return false;
+}
+
+bool FileMenu::save_replay(bool) {
+    SolidFactory& factory = SolidFactory::instance();
+
+    if (!factory.replaying())
+        return false;
+
+    int shown_step = *factory.replay_step_ptr();
+    int stride = ci::math<int>::max(replay_stride_, 1);
+
+    for (int step = 0; step < factory.replay_num_steps(); step += stride) {
+        if (!factory.show_replay_step(step))
+            break;
+
+        std::ostringstream ss;
+        ss << file_name_ << "step_" << step;
+
+        Renderer::instance().save_image(high_res_image_width_, ss.str() + ".png");
+
+        if (replay_dxf_)
+            write_dxf(ss.str() + ".dxf");
+    }
+
+    factory.show_replay_step(shown_step);
+
+    return false;
+}
+
+void FileMenu::write_dxf(const std::string& file_name) {
+    DxfSaver saver = DxfSaver(file_name);
 
     saver.begin();
 
@@ -913,8 +1498,6 @@ bool FileMenu::save_dxf(bool) {
         } );
 
     saver.end();
-
-    return false;
 }
 
 
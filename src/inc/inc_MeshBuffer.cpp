@@ -0,0 +1,188 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+
+#include <cinder/CinderMath.h>
+
+#include <inc/inc_MeshBuffer.h>
+#include <inc/inc_Color.h>
+
+namespace inc {
+
+void MeshBuffer::Vertex::set(const btVector3& p, const btVector3& n, 
+    const ci::ColorA& c) {
+    set(p, n);
+
+    color[0] = (GLubyte) (ci::math<float>::clamp(c.r) * 255.0f + 0.5f);
+    color[1] = (GLubyte) (ci::math<float>::clamp(c.g) * 255.0f + 0.5f);
+    color[2] = (GLubyte) (ci::math<float>::clamp(c.b) * 255.0f + 0.5f);
+    color[3] = (GLubyte) (ci::math<float>::clamp(c.a) * 255.0f + 0.5f);
+}
+
+void MeshBuffer::Vertex::set(const btVector3& p, const btVector3& n) {
+    position[0] = p.x();
+    position[1] = p.y();
+    position[2] = p.z();
+
+    normal[0] = n.x();
+    normal[1] = n.y();
+    normal[2] = n.z();
+}
+
+void MeshBuffer::Vertex::set(const ci::Vec3f& p, const ci::Vec3f& n, 
+    const ci::ColorA& c) {
+    set(btVector3(p.x, p.y, p.z), btVector3(n.x, n.y, n.z), c);
+}
+
+MeshBuffer::MeshBuffer(GLenum usage) : usage_(usage) {
+    initialized_ = false;
+    num_vertices_ = 0;
+    num_triangle_indices_ = 0;
+    num_edge_indices_ = 0;
+    staged_ = false;
+}
+
+// the buffers are made on first use, when there's sure to be a context
+void MeshBuffer::init() {
+    if (initialized_)
+        return;
+
+    vertices_ = ci::gl::Vbo(GL_ARRAY_BUFFER);
+    triangles_ = ci::gl::Vbo(GL_ELEMENT_ARRAY_BUFFER);
+    edges_ = ci::gl::Vbo(GL_ELEMENT_ARRAY_BUFFER);
+
+    initialized_ = true;
+}
+
+void MeshBuffer::set_triangles(const std::vector<GLuint>& indices) {
+    init();
+
+    std::vector<GLuint> edges;
+    find_edges(indices, edges);
+
+    num_triangle_indices_ = (int) indices.size();
+    num_edge_indices_ = (int) edges.size();
+
+    if (indices.empty())
+        return;
+
+    triangles_.bind();
+    triangles_.bufferData(indices.size() * sizeof(GLuint), &indices[0], 
+        GL_STATIC_DRAW);
+    triangles_.unbind();
+
+    edges_.bind();
+    edges_.bufferData(edges.size() * sizeof(GLuint), &edges[0], 
+        GL_STATIC_DRAW);
+    edges_.unbind();
+}
+
+MeshBuffer::Vertex* MeshBuffer::map(int num_vertices) {
+    init();
+
+    num_vertices_ = num_vertices;
+    staged_ = false;
+
+    if (num_vertices == 0)
+        return NULL;
+
+    vertices_.bind();
+    vertices_.bufferData(num_vertices * sizeof(Vertex), NULL, usage_);
+
+    Vertex* mapped = (Vertex*) vertices_.map(GL_WRITE_ONLY);
+
+    if (mapped != NULL)
+        return mapped;
+
+    staging_.resize(num_vertices);
+    staged_ = true;
+
+    return &staging_[0];
+}
+
+void MeshBuffer::unmap() {
+    if (staged_) {
+        vertices_.bufferSubData(0, num_vertices_ * sizeof(Vertex), &staging_[0]);
+        staged_ = false;
+    } else {
+        vertices_.unmap();
+    }
+
+    vertices_.unbind();
+}
+
+void MeshBuffer::bind_vertices(bool attributes) {
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    vertices_.bind();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(Vertex), 
+        (const GLvoid*) offsetof(Vertex, position));
+
+    if (!attributes)
+        return;
+
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, sizeof(Vertex), 
+        (const GLvoid*) offsetof(Vertex, normal));
+
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), 
+        (const GLvoid*) offsetof(Vertex, color));
+}
+
+void MeshBuffer::unbind_vertices() {
+    vertices_.unbind();
+
+    glPopClientAttrib();
+}
+
+void MeshBuffer::draw_triangles() {
+    if (num_vertices_ == 0 || num_triangle_indices_ == 0)
+        return;
+
+    Color::begin_vertex_colors();
+
+    bind_vertices(true);
+
+    triangles_.bind();
+    glDrawElements(GL_TRIANGLES, num_triangle_indices_, GL_UNSIGNED_INT, 0);
+    triangles_.unbind();
+
+    unbind_vertices();
+
+    Color::end_vertex_colors();
+}
+
+void MeshBuffer::draw_edges() {
+    if (num_vertices_ == 0 || num_edge_indices_ == 0)
+        return;
+
+    bind_vertices(false);
+
+    edges_.bind();
+    glDrawElements(GL_LINES, num_edge_indices_, GL_UNSIGNED_INT, 0);
+    edges_.unbind();
+
+    unbind_vertices();
+}
+
+}
@@ -139,7 +139,10 @@ std::tr1::shared_ptr<std::vector<ci::Vec3f> > MeshCreator::make_half_circle(
 void MeshCreator::add_circle_mesh(ci::Vec3f center, float radius) {
     std::tr1::shared_ptr<ci::TriMesh> mesh = generate_circle_mesh(center, radius);
 
-    Manager::instance().add_solid(SolidFactory::create_soft_mesh(mesh));
+    SoftSolidPtr solid = SolidFactory::create_soft_mesh(mesh);
+
+    if (solid)
+        Manager::instance().add_solid(solid);
 }
 
 void MeshCreator::draw() {
@@ -177,7 +180,8 @@ void MeshCreator::add_bspline_mesh(std::tr1::shared_ptr<ci::BSpline3f> bspline)
 
     current_mesh_ = SolidFactory::create_soft_mesh(mesh);
 
-    Manager::instance().add_solid(current_mesh_);
+    if (current_mesh_)
+        Manager::instance().add_solid(current_mesh_);
 }
 
 TriMeshPtr MeshCreator::generate_bspline_dome_mesh(
@@ -192,10 +196,12 @@ TriMeshPtr MeshCreator::generate_bspline_dome_mesh(
     ci::Vec3f mid_point;
     std::vector<ci::Vec3f> base_points;
 
-    for (int i = 0; i < slice_res; ++i) {
-        float t = ci::lmap<float>(i, 0, slice_res - 1, 0, 1.0f);
+    spline_sampler_.sample_uniform(bspline, slice_res);
 
-        ci::Vec3f v = bspline->getPosition(t);
+    const std::vector<ci::Vec3f>& samples = spline_sampler_.positions();
+
+    for (int i = 0; i < slice_res; ++i) {
+        const ci::Vec3f& v = samples[i];
 
         if (i == 0) {
             start_point = v;
@@ -304,16 +310,11 @@ MeshCreator::generate_bspline_revolve_points(
     // perp = vector lying in disc
     ci::Vec3f perp = axis.cross(alt);
 
-    std::vector<ci::Vec3f> base_points;
-
     // sample the bspline
 
-    float t;
-    for (int i = 0; i < slice_res; ++i) {
-        t = ci::lmap<float>(i, 0, slice_res - 1, 0, 1.0f);
+    spline_sampler_.sample_uniform(bspline, slice_res);
 
-        base_points.push_back(bspline->getPosition(t));
-    }
+    const std::vector<ci::Vec3f>& base_points = spline_sampler_.positions();
 
     // create the vertices of the mesh
 
@@ -600,7 +601,8 @@ void MeshCreator::add_obj_mesh(const std::string& file_name,
 
     current_mesh_ = SolidFactory::create_soft_mesh(mesh_ptr, scl);
 
-    Manager::instance().add_solid(current_mesh_);
+    if (current_mesh_)
+        Manager::instance().add_solid(current_mesh_);
 }
 
 void MeshCreator::add_tripod_mesh() {
@@ -70,6 +70,9 @@ void MeshNetwork::create_tube_union() {
     SolidPtr union_solid = SolidFactory::create_soft_mesh(
         CSG::csg_solid_to_tri_mesh(tube_union), scl);
 
+    if (!union_solid)
+        return;
+
     Manager::instance().add_solid(union_solid);
     MeshCreator::instance().set_current_mesh(union_solid);
 }
@@ -0,0 +1,202 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#include <cinder/CinderMath.h>
+
+#include <inc/inc_MeshWelder.h>
+
+namespace inc {
+
+namespace {
+
+// a small tolerance on a large mesh puts the cells past what an int holds.
+// Those all share the last index, which only makes the search slower since
+// find_nearest still checks distances, and leaves room for its + 1
+const float kMaxCell = 1.0e9f;
+
+int cell_index(float v) {
+    float f = ci::math<float>::floor(v);
+
+    if (f >= kMaxCell)
+        return (int) kMaxCell;
+    if (f > -kMaxCell)
+        return (int) f;
+
+    return -(int) kMaxCell; // or NaN
+}
+
+}
+
+MeshWelder::MeshWelder(float tolerance) {
+    tolerance_ = ci::math<float>::max(tolerance, 0.0f);
+    min_y_ = 0.0f;
+    max_y_ = 0.0f;
+}
+
+void MeshWelder::reserve(size_t num_vertices) {
+    vertices_.reserve(num_vertices);
+    cells_.rehash(num_vertices);
+}
+
+void MeshWelder::clear() {
+    vertices_.clear();
+    cells_.clear();
+    remap_.clear();
+    min_y_ = 0.0f;
+    max_y_ = 0.0f;
+}
+
+MeshWelder::Cell MeshWelder::cell(const ci::Vec3f& v) {
+    Cell c;
+
+    if (tolerance_ > 0.0f) {
+        c.x = cell_index(v.x / tolerance_);
+        c.y = cell_index(v.y / tolerance_);
+        c.z = cell_index(v.z / tolerance_);
+    } else {
+        // exact matching hashes the bits, + 0.0f turns -0 into 0
+        float x = v.x + 0.0f;
+        float y = v.y + 0.0f;
+        float z = v.z + 0.0f;
+
+        memcpy(&c.x, &x, sizeof(int));
+        memcpy(&c.y, &y, sizeof(int));
+        memcpy(&c.z, &z, sizeof(int));
+    }
+
+    return c;
+}
+
+int MeshWelder::find_exact(const ci::Vec3f& v, const Cell& c) {
+    std::pair<CellMap::const_iterator, CellMap::const_iterator> range = 
+        cells_.equal_range(c);
+
+    for (CellMap::const_iterator it = range.first; it != range.second; ++it) {
+        if (vertices_[it->second] == v)
+            return it->second;
+    }
+
+    return -1;
+}
+
+int MeshWelder::find_nearest(const ci::Vec3f& v, const Cell& c) {
+    // the cells are as wide as the tolerance, so anything close enough is 
+    // in this cell or one next to it
+    float best = tolerance_ * tolerance_;
+    int best_index = -1;
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                Cell n = { c.x + dx, c.y + dy, c.z + dz };
+
+                std::pair<CellMap::const_iterator, CellMap::const_iterator> 
+                    range = cells_.equal_range(n);
+
+                for (CellMap::const_iterator it = range.first; 
+                    it != range.second; ++it) {
+                    float d = vertices_[it->second].distanceSquared(v);
+
+                    if (d <= best) {
+                        best = d;
+                        best_index = it->second;
+                    }
+                }
+            }
+        }
+    }
+
+    return best_index;
+}
+
+int MeshWelder::add(const ci::Vec3f& v) {
+    Cell c = cell(v);
+
+    int index = tolerance_ > 0.0f ? find_nearest(v, c) : find_exact(v, c);
+
+    if (index >= 0)
+        return index;
+
+    index = (int) vertices_.size();
+    vertices_.push_back(v);
+    cells_.insert(std::make_pair(c, index));
+
+    if (index == 0) {
+        min_y_ = v.y;
+        max_y_ = v.y;
+    } else {
+        min_y_ = ci::math<float>::min(min_y_, v.y);
+        max_y_ = ci::math<float>::max(max_y_, v.y);
+    }
+
+    return index;
+}
+
+void MeshWelder::weld(const ci::TriMesh& mesh, std::vector<int>& triangles) {
+    const std::vector<ci::Vec3f>& vertices = mesh.getVertices();
+    const std::vector<size_t>& indices = mesh.getIndices();
+
+    reserve(vertices_.size() + vertices.size());
+    remap_.resize(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+        remap_[i] = add(vertices[i]);
+
+    triangles.clear();
+    triangles.reserve(indices.size());
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        int in1 = remap_[indices[i]];
+        int in2 = remap_[indices[i + 1]];
+        int in3 = remap_[indices[i + 2]];
+
+        if (in1 == in2 || in2 == in3 || in1 == in3)
+            continue;
+
+        triangles.push_back(in1);
+        triangles.push_back(in2);
+        triangles.push_back(in3);
+    }
+}
+
+std::tr1::shared_ptr<ci::TriMesh> MeshWelder::weld(const ci::TriMesh& mesh,
+    float tolerance) {
+    MeshWelder welder(tolerance);
+    std::vector<int> triangles;
+
+    welder.weld(mesh, triangles);
+
+    std::tr1::shared_ptr<ci::TriMesh> mesh_ptr = 
+        std::tr1::shared_ptr<ci::TriMesh>(new ci::TriMesh());
+
+    const std::vector<ci::Vec3f>& welded = welder.vertices();
+
+    for (size_t i = 0; i < welded.size(); ++i)
+        mesh_ptr->appendVertex(welded[i]);
+
+    for (size_t i = 0; i < triangles.size(); i += 3)
+        mesh_ptr->appendTriangle(triangles[i], triangles[i + 1], 
+            triangles[i + 2]);
+
+    return mesh_ptr;
+}
+
+}
@@ -31,6 +31,9 @@ Origin::Origin() {
 
     create_ground_plane_ = false;
     draw_grid_ = false;
+
+    // made here so the menus can hook into it before setup
+    origin_graphic_item_ = new OriginGraphicItem();
 }
 
 Origin::~Origin() {
@@ -42,8 +45,6 @@ Origin::~Origin() {
 }
 
 void Origin::setup() {
-    origin_graphic_item_ = new OriginGraphicItem();
-
     /*
     interface_ = ci::params::InterfaceGl("Origin", ci::Vec2i(100, 200));
     interface_.addParam("Grid Plane Size", 
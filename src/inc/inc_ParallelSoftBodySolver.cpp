@@ -0,0 +1,249 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include <cinder/app/App.h>
+
+#include <inc/inc_ParallelSoftBodySolver.h>
+#include <inc/inc_TaskPool.h>
+
+namespace inc {
+
+ParallelSoftBodySolver::ParallelSoftBodySolver(TaskPool& pool) : pool_(pool) {
+    enabled_ = true;
+    deterministic_ = true;
+}
+
+ParallelSoftBodySolver::~ParallelSoftBodySolver() {
+#ifdef TRACE_DTORS
+    ci::app::console() << "Deleting ParallelSoftBodySolver" << std::endl;
+#endif
+}
+
+bool ParallelSoftBodySolver::use_threads() {
+    return enabled_ && pool_.num_threads() > 1 && m_softBodySet.size() > 1;
+}
+
+void ParallelSoftBodySolver::predictMotion(float solverdt) {
+    // the contacts are cleared and the nodes move, so the hash grids go
+    collider_.begin_step();
+
+    if (!use_threads()) {
+        btDefaultSoftBodySolver::predictMotion(solverdt);
+        return;
+    }
+
+    active_.clear();
+    proxies_.clear();
+
+    // predictMotion ends by moving the body's proxy in the broadphase, which 
+    // isn't thread safe, so the proxies are detached during the parallel part
+    // and updated afterwards
+    for (int i = 0; i < m_softBodySet.size(); ++i) {
+        btSoftBody* psb = m_softBodySet[i];
+
+        if (!psb->isActive())
+            continue;
+
+        active_.push_back(psb);
+        proxies_.push_back(psb->getBroadphaseHandle());
+        psb->setBroadphaseHandle(NULL);
+    }
+
+    pool_.parallel_for(0, (int) active_.size(), [&] (int i) {
+        active_[i]->predictMotion(solverdt);
+    }, deterministic_);
+
+    for (size_t i = 0; i < active_.size(); ++i) {
+        btSoftBody* psb = active_[i];
+
+        psb->setBroadphaseHandle(proxies_[i]);
+
+        if (proxies_[i] != NULL) {
+            psb->m_worldInfo->m_broadphase->setAabb(proxies_[i], 
+                psb->m_bounds[0], psb->m_bounds[1], psb->m_worldInfo->m_dispatcher);
+        }
+    }
+}
+
+void ParallelSoftBodySolver::solveConstraints(float solverdt) {
+    if (!use_threads()) {
+        btDefaultSoftBodySolver::solveConstraints(solverdt);
+        return;
+    }
+
+    build_islands();
+
+    pool_.parallel_for(0, (int) islands_.size(), [&] (int i) {
+        std::vector<btSoftBody*>& island = islands_[i];
+
+        for (size_t j = 0; j < island.size(); ++j)
+            island[j]->solveConstraints();
+    }, deterministic_);
+}
+
+void ParallelSoftBodySolver::processCollision(btSoftBody* a, btSoftBody* b) {
+    if (collider_.handles(a, b)) {
+        collider_.collide(a, b);
+        return;
+    }
+
+    btDefaultSoftBodySolver::processCollision(a, b);
+}
+
+void ParallelSoftBodySolver::build_islands() {
+    // sleeping bodies aren't solved, but they are still in the union find,
+    // since two active bodies touching the same sleeping one both write to it
+    bodies_.clear();
+
+    for (int i = 0; i < m_softBodySet.size(); ++i)
+        bodies_.push_back(m_softBodySet[i]);
+
+    int num_bodies = (int) bodies_.size();
+
+    parents_.resize(num_bodies);
+    for (int i = 0; i < num_bodies; ++i)
+        parents_[i] = i;
+
+    rigid_ids_.clear();
+    node_ranges_.clear();
+
+    for (int i = 0; i < num_bodies; ++i) {
+        if (bodies_[i]->m_nodes.size() > 0)
+            node_ranges_.push_back(std::make_pair(
+                (const btSoftBody::Node*) &bodies_[i]->m_nodes[0], i));
+    }
+
+    std::sort(node_ranges_.begin(), node_ranges_.end());
+
+    for (int i = 0; i < num_bodies; ++i) {
+        btSoftBody* psb = bodies_[i];
+
+        // anchors and rigid contacts push on the rigid body
+        for (int j = 0; j < psb->m_anchors.size(); ++j)
+            join(i, rigid_id(psb->m_anchors[j].m_body));
+
+        for (int j = 0; j < psb->m_rcontacts.size(); ++j)
+            join(i, rigid_id(psb->m_rcontacts[j].m_cti.m_colObj));
+
+        // soft contacts move the other body's face
+        for (int j = 0; j < psb->m_scontacts.size(); ++j)
+            join(i, node_owner(psb->m_scontacts[j].m_face->m_n[0]));
+
+        for (int j = 0; j < psb->m_joints.size(); ++j) {
+            for (int k = 0; k < 2; ++k) {
+                const btSoftBody::Body& body = psb->m_joints[j]->m_bodies[k];
+
+                if (body.m_soft != NULL && body.m_soft->m_nodes.size() > 0)
+                    join(i, node_owner(body.m_soft->m_nodes[0]));
+                else
+                    join(i, rigid_id(body.m_collisionObject));
+            }
+        }
+    }
+
+    // islands are ordered by their first body, and bodies within an island
+    // keep the world's order
+    std::vector<int> island_of(parents_.size(), -1);
+
+    islands_.clear();
+
+    for (int i = 0; i < num_bodies; ++i) {
+        if (!bodies_[i]->isActive())
+            continue;
+
+        int root = find_root(i);
+
+        if (island_of[root] < 0) {
+            island_of[root] = (int) islands_.size();
+            islands_.push_back(std::vector<btSoftBody*>());
+        }
+
+        islands_[island_of[root]].push_back(bodies_[i]);
+    }
+}
+
+int ParallelSoftBodySolver::find_root(int i) {
+    while (parents_[i] != i) {
+        parents_[i] = parents_[parents_[i]];
+        i = parents_[i];
+    }
+
+    return i;
+}
+
+void ParallelSoftBodySolver::join(int a, int b) {
+    if (a < 0 || b < 0)
+        return;
+
+    a = find_root(a);
+    b = find_root(b);
+
+    if (a == b)
+        return;
+
+    // keep the lowest index as the root so island order is stable
+    if (a < b)
+        parents_[b] = a;
+    else
+        parents_[a] = b;
+}
+
+// static and kinematic objects aren't written to by the solve, so they 
+// don't link islands
+int ParallelSoftBodySolver::rigid_id(const btCollisionObject* obj) {
+    if (obj == NULL || obj->isStaticOrKinematicObject())
+        return -1;
+
+    std::map<const btCollisionObject*, int>::iterator it = rigid_ids_.find(obj);
+
+    if (it != rigid_ids_.end())
+        return it->second;
+
+    int id = (int) parents_.size();
+
+    parents_.push_back(id);
+    rigid_ids_[obj] = id;
+
+    return id;
+}
+
+int ParallelSoftBodySolver::node_owner(const btSoftBody::Node* node) {
+    if (node_ranges_.empty())
+        return -1;
+
+    std::vector<std::pair<const btSoftBody::Node*, int> >::iterator it = 
+        std::upper_bound(node_ranges_.begin(), node_ranges_.end(),
+        std::make_pair(node, (int) bodies_.size()));
+
+    if (it == node_ranges_.begin())
+        return -1;
+
+    --it;
+
+    btSoftBody* psb = bodies_[it->second];
+
+    if (node >= &psb->m_nodes[0] + psb->m_nodes.size())
+        return -1;
+
+    return it->second;
+}
+
+}
@@ -0,0 +1,418 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include <LinearMath/btQuickprof.h>
+#include <BulletSoftBody/btSoftBody.h>
+
+#include <inc/inc_PhysicsProfiler.h>
+
+namespace inc {
+
+namespace {
+
+#ifndef BT_NO_PROFILE
+// appends the sections under the iterator's node, depth first, and returns
+// the time of its direct children
+double read_profile_node(CProfileIterator* it, const std::string& prefix,
+    std::vector<PhysicsProfiler::Section>& sections) {
+    size_t first = sections.size();
+    double total = 0.0;
+
+    for (it->First(); !it->Is_Done(); it->Next()) {
+        PhysicsProfiler::Section section;
+        section.name = prefix + it->Get_Current_Name();
+        section.ms = it->Get_Current_Total_Time();
+        section.self_ms = section.ms;
+        section.calls = it->Get_Current_Total_Calls();
+        section.bullet = true;
+
+        sections.push_back(section);
+        total += section.ms;
+    }
+
+    size_t last = sections.size();
+
+    // entering a child starts the iteration over, so the children are 
+    // visited once the names at this level are all in
+    for (size_t i = first; i < last; ++i) {
+        it->Enter_Child((int) (i - first));
+        double inner = read_profile_node(it, sections[i].name + "/", sections);
+        it->Enter_Parent();
+
+        sections[i].self_ms -= inner;
+    }
+
+    return total;
+}
+#endif
+
+bool slower(const PhysicsProfiler::Section& a, 
+    const PhysicsProfiler::Section& b) {
+    return a.self_ms > b.self_ms;
+}
+
+std::string json_string(const std::string& s) {
+    std::string out = "\"";
+
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '"' || s[i] == '\\')
+            out += '\\';
+        out += s[i];
+    }
+
+    return out + "\"";
+}
+
+}
+
+PhysicsProfiler::Frame::Frame() {
+    number = 0;
+    ms = 0.0;
+}
+
+PhysicsProfiler::Scope::Scope(PhysicsProfiler& profiler, const char* name)
+    : profiler_(&profiler), name_(name) {
+    start_ = profiler_->in_frame_ ? profiler_->clock_.getSeconds() : 0.0;
+}
+
+PhysicsProfiler::Scope::~Scope() {
+    if (!profiler_->in_frame_)
+        return;
+
+    profiler_->add_time(name_, 
+        (profiler_->clock_.getSeconds() - start_) * 1000.0);
+}
+
+PhysicsProfiler::PhysicsProfiler() {
+    enabled_ = false;
+    log_ = false;
+    log_format_ = CSV;
+    log_name_ = "physics_profile";
+
+    settings_.enabled = enabled_;
+    settings_.log = log_;
+    settings_.log_format = log_format_;
+    settings_.log_name = log_name_;
+    published_settings_ = settings_;
+    log_failed_ = false;
+
+    clock_.start();
+    in_frame_ = false;
+    frame_start_ = 0.0;
+
+    open_format_ = CSV;
+
+    frame_ms_ = 0.0f;
+}
+
+void PhysicsProfiler::begin_frame() {
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        settings_ = published_settings_;
+    }
+
+    in_frame_ = settings_.enabled;
+
+    if (!in_frame_)
+        return;
+
+    frame_.sections.clear();
+    frame_.bodies.clear();
+    frame_start_ = clock_.getSeconds();
+
+#ifndef BT_NO_PROFILE
+    CProfileManager::Reset();
+#endif
+}
+
+void PhysicsProfiler::end_frame(btCollisionWorld* world) {
+    if (!in_frame_)
+        return;
+
+    in_frame_ = false;
+
+    frame_.ms = (clock_.getSeconds() - frame_start_) * 1000.0;
+    ++frame_.number;
+
+    read_bullet_profile(frame_);
+    read_bodies(world, frame_);
+    write_log(frame_);
+
+    boost::mutex::scoped_lock lock(mutex_);
+    latest_ = frame_;
+}
+
+void PhysicsProfiler::add_time(const char* name, double ms) {
+    for (size_t i = 0; i < frame_.sections.size(); ++i) {
+        Section& section = frame_.sections[i];
+
+        if (section.name == name) {
+            section.ms += ms;
+            section.self_ms += ms;
+            ++section.calls;
+            return;
+        }
+    }
+
+    Section section;
+    section.name = name;
+    section.ms = ms;
+    section.self_ms = ms;
+    section.calls = 1;
+    section.bullet = false;
+
+    frame_.sections.push_back(section);
+}
+
+void PhysicsProfiler::read_bullet_profile(Frame& frame) {
+#ifndef BT_NO_PROFILE
+    CProfileIterator* it = CProfileManager::Get_Iterator();
+
+    read_profile_node(it, "", frame.sections);
+
+    CProfileManager::Release_Iterator(it);
+#endif
+}
+
+void PhysicsProfiler::read_bodies(btCollisionWorld* world, Frame& frame) {
+    btCollisionObjectArray& objects = world->getCollisionObjectArray();
+    std::map<const void*, int> index;
+
+    frame.bodies.resize(objects.size());
+
+    for (int i = 0; i < objects.size(); ++i) {
+        Body& body = frame.bodies[i];
+        btSoftBody* soft_body = btSoftBody::upcast(objects[i]);
+
+        body.index = i;
+        body.pairs = 0;
+        index[objects[i]] = i;
+
+        if (soft_body == NULL) {
+            body.nodes = body.links = body.faces = body.clusters = -1;
+            body.contacts = 0;
+            continue;
+        }
+
+        body.nodes = soft_body->m_nodes.size();
+        body.links = soft_body->m_links.size();
+        body.faces = soft_body->m_faces.size();
+        body.clusters = soft_body->m_clusters.size();
+        // self collision contacts are among the soft contacts
+        body.contacts = soft_body->m_rcontacts.size() + 
+            soft_body->m_scontacts.size();
+    }
+
+    btBroadphasePairArray& pairs = world->getBroadphase()->
+        getOverlappingPairCache()->getOverlappingPairArray();
+
+    for (int i = 0; i < pairs.size(); ++i) {
+        std::map<const void*, int>::iterator a = 
+            index.find(pairs[i].m_pProxy0->m_clientObject);
+        std::map<const void*, int>::iterator b = 
+            index.find(pairs[i].m_pProxy1->m_clientObject);
+
+        if (a != index.end())
+            ++frame.bodies[a->second].pairs;
+        if (b != index.end())
+            ++frame.bodies[b->second].pairs;
+    }
+
+    btDispatcher* dispatcher = world->getDispatcher();
+
+    for (int i = 0; i < dispatcher->getNumManifolds(); ++i) {
+        btPersistentManifold* manifold = 
+            dispatcher->getManifoldByIndexInternal(i);
+        std::map<const void*, int>::iterator a = index.find(manifold->getBody0());
+        std::map<const void*, int>::iterator b = index.find(manifold->getBody1());
+
+        if (a != index.end() && frame.bodies[a->second].nodes < 0)
+            frame.bodies[a->second].contacts += manifold->getNumContacts();
+        if (b != index.end() && frame.bodies[b->second].nodes < 0)
+            frame.bodies[b->second].contacts += manifold->getNumContacts();
+    }
+}
+
+void PhysicsProfiler::write_log(const Frame& frame) {
+    if (!settings_.log) {
+        if (log_file_.is_open())
+            log_file_.close();
+        return;
+    }
+
+    if (log_file_.is_open() && open_format_ != settings_.log_format)
+        log_file_.close();
+
+    if (!log_file_.is_open()) {
+        open_format_ = settings_.log_format;
+        log_file_.open((settings_.log_name + 
+            (open_format_ == JSON ? ".json" : ".csv")).c_str());
+
+        if (!log_file_.is_open()) {
+            settings_.log = false;
+
+            boost::mutex::scoped_lock lock(mutex_);
+            log_failed_ = true;
+
+            return;
+        }
+
+        if (open_format_ == CSV) {
+            log_file_ << "frame,kind,name,ms,self_ms,calls,nodes,links,faces,"
+                "clusters,contacts,pairs" << std::endl;
+        }
+    }
+
+    if (open_format_ == CSV) {
+        log_file_ << frame.number << ",frame,," << frame.ms << ",,,,,,,,\n";
+
+        for (size_t i = 0; i < frame.sections.size(); ++i) {
+            const Section& s = frame.sections[i];
+
+            log_file_ << frame.number << (s.bullet ? ",bullet," : ",section,") 
+                << s.name << "," << s.ms << "," << s.self_ms << "," << 
+                s.calls << ",,,,,,\n";
+        }
+
+        for (size_t i = 0; i < frame.bodies.size(); ++i) {
+            const Body& b = frame.bodies[i];
+
+            log_file_ << frame.number << (b.nodes < 0 ? ",rigid," : ",soft,") 
+                << b.index << ",,,," << b.nodes << "," << b.links << "," << 
+                b.faces << "," << b.clusters << "," << b.contacts << "," << 
+                b.pairs << "\n";
+        }
+    } else {
+        log_file_ << "{\"frame\": " << frame.number << ", \"ms\": " << 
+            frame.ms << ", \"sections\": [";
+
+        for (size_t i = 0; i < frame.sections.size(); ++i) {
+            const Section& s = frame.sections[i];
+
+            log_file_ << (i > 0 ? ", " : "") << "{\"name\": " << 
+                json_string(s.name) << ", \"bullet\": " << 
+                (s.bullet ? "true" : "false") << ", \"ms\": " << s.ms << 
+                ", \"self_ms\": " << s.self_ms << ", \"calls\": " << s.calls <<
+                "}";
+        }
+
+        log_file_ << "], \"bodies\": [";
+
+        for (size_t i = 0; i < frame.bodies.size(); ++i) {
+            const Body& b = frame.bodies[i];
+
+            log_file_ << (i > 0 ? ", " : "") << "{\"index\": " << b.index <<
+                ", \"soft\": " << (b.nodes < 0 ? "false" : "true") << 
+                ", \"nodes\": " << b.nodes << ", \"links\": " << b.links << 
+                ", \"faces\": " << b.faces << ", \"clusters\": " << 
+                b.clusters << ", \"contacts\": " << b.contacts << 
+                ", \"pairs\": " << b.pairs << "}";
+        }
+
+        log_file_ << "]}\n";
+    }
+}
+
+void PhysicsProfiler::update_readout() {
+    Frame frame;
+
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        frame = latest_;
+
+        if (log_failed_) {
+            log_ = false;
+            log_failed_ = false;
+        }
+
+        published_settings_.enabled = enabled_;
+        published_settings_.log = log_;
+        published_settings_.log_format = log_format_;
+        published_settings_.log_name = log_name_;
+    }
+
+    frame_ms_ = (float) frame.ms;
+
+    std::stringstream ours;
+    std::vector<Section> bullet;
+
+    ours.precision(3);
+
+    for (size_t i = 0; i < frame.sections.size(); ++i) {
+        const Section& s = frame.sections[i];
+
+        if (s.bullet) {
+            bullet.push_back(s);
+            continue;
+        }
+
+        if (ours.tellp() > 0)
+            ours << "  ";
+
+        ours << s.name << " " << s.ms;
+    }
+
+    sections_ = ours.str();
+
+    // the slowest few by their own time, named by the last part of the path
+    size_t shown = std::min<size_t>(bullet.size(), 3);
+    std::partial_sort(bullet.begin(), bullet.begin() + shown, bullet.end(),
+        slower);
+
+    std::stringstream theirs;
+    theirs.precision(3);
+
+    for (size_t i = 0; i < shown; ++i) {
+        const std::string& name = bullet[i].name;
+
+        if (i > 0)
+            theirs << "  ";
+
+        theirs << name.substr(name.rfind('/') + 1) << " " << bullet[i].self_ms;
+    }
+
+    bullet_sections_ = theirs.str();
+
+    const Body* largest = NULL;
+
+    for (size_t i = 0; i < frame.bodies.size(); ++i) {
+        if (frame.bodies[i].nodes >= 0 && 
+            (largest == NULL || frame.bodies[i].nodes > largest->nodes))
+            largest = &frame.bodies[i];
+    }
+
+    if (largest == NULL) {
+        largest_soft_body_ = "";
+        return;
+    }
+
+    std::stringstream ss;
+
+    ss << "#" << largest->index << ": " << largest->nodes << " nodes " << 
+        largest->links << " links " << largest->faces << " faces " << 
+        largest->contacts << " contacts " << largest->pairs << " pairs";
+
+    largest_soft_body_ = ss.str();
+}
+
+}
@@ -0,0 +1,170 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <BulletSoftBody/btSoftBody.h>
+
+#include <inc/inc_PhysicsSnapshot.h>
+
+namespace inc {
+
+// vectors per rigid body, see data_
+static const int kRigidSize = 6;
+
+PhysicsSnapshot::PhysicsSnapshot() {
+}
+
+void PhysicsSnapshot::clear() {
+    objects_.clear();
+    data_.clear();
+}
+
+void PhysicsSnapshot::capture(btCollisionWorld* world) {
+    btCollisionObjectArray& array = world->getCollisionObjectArray();
+
+    clear();
+    objects_.resize(array.size());
+
+    // sized up front so the copies below never reallocate
+    int size = 0;
+
+    for (int i = 0; i < array.size(); ++i) {
+        btSoftBody* soft_body = btSoftBody::upcast(array[i]);
+
+        objects_[i].object = array[i];
+        objects_[i].num_nodes = soft_body ? soft_body->m_nodes.size() : -1;
+
+        size += soft_body ? soft_body->m_nodes.size() * 2 : kRigidSize;
+    }
+
+    data_.resize(size);
+    btVector3* out = size > 0 ? &data_[0] : NULL;
+
+    for (int i = 0; i < array.size(); ++i) {
+        btSoftBody* soft_body = btSoftBody::upcast(array[i]);
+
+        if (soft_body) {
+            btSoftBody::tNodeArray& nodes = soft_body->m_nodes;
+
+            for (int j = 0; j < nodes.size(); ++j) {
+                *out++ = nodes[j].m_x;
+                *out++ = nodes[j].m_v;
+            }
+
+            continue;
+        }
+
+        const btTransform& transform = array[i]->getWorldTransform();
+
+        *out++ = transform.getBasis()[0];
+        *out++ = transform.getBasis()[1];
+        *out++ = transform.getBasis()[2];
+        *out++ = transform.getOrigin();
+
+        btRigidBody* rigid_body = btRigidBody::upcast(array[i]);
+
+        *out++ = rigid_body ? rigid_body->getLinearVelocity() : 
+            btVector3(0, 0, 0);
+        *out++ = rigid_body ? rigid_body->getAngularVelocity() : 
+            btVector3(0, 0, 0);
+    }
+}
+
+bool PhysicsSnapshot::matches(btCollisionWorld* world) {
+    btCollisionObjectArray& array = world->getCollisionObjectArray();
+
+    if (array.size() != (int) objects_.size())
+        return false;
+
+    for (int i = 0; i < array.size(); ++i) {
+        if (array[i] != objects_[i].object)
+            return false;
+
+        btSoftBody* soft_body = btSoftBody::upcast(array[i]);
+        int num_nodes = soft_body ? soft_body->m_nodes.size() : -1;
+
+        if (num_nodes != objects_[i].num_nodes)
+            return false;
+    }
+
+    return true;
+}
+
+bool PhysicsSnapshot::restore(btCollisionWorld* world) {
+    if (empty() || !matches(world))
+        return false;
+
+    btCollisionObjectArray& array = world->getCollisionObjectArray();
+    const btVector3* in = data_.size() > 0 ? &data_[0] : NULL;
+
+    for (int i = 0; i < array.size(); ++i) {
+        btSoftBody* soft_body = btSoftBody::upcast(array[i]);
+
+        if (soft_body) {
+            btSoftBody::tNodeArray& nodes = soft_body->m_nodes;
+
+            for (int j = 0; j < nodes.size(); ++j) {
+                btSoftBody::Node& node = nodes[j];
+
+                node.m_x = *in++;
+                node.m_v = *in++;
+                // no motion carried over from before the restore
+                node.m_q = node.m_x;
+                node.m_f = btVector3(0, 0, 0);
+            }
+
+            // the normals are drawn before the next step would fix them
+            soft_body->updateNormals();
+            soft_body->updateBounds();
+            soft_body->activate(true);
+
+            continue;
+        }
+
+        btTransform transform;
+        transform.getBasis().setValue(
+            in[0].x(), in[0].y(), in[0].z(),
+            in[1].x(), in[1].y(), in[1].z(),
+            in[2].x(), in[2].y(), in[2].z());
+        transform.setOrigin(in[3]);
+
+        array[i]->setWorldTransform(transform);
+        array[i]->setInterpolationWorldTransform(transform);
+
+        btRigidBody* rigid_body = btRigidBody::upcast(array[i]);
+
+        if (rigid_body) {
+            rigid_body->setLinearVelocity(in[4]);
+            rigid_body->setAngularVelocity(in[5]);
+            rigid_body->setInterpolationLinearVelocity(in[4]);
+            rigid_body->setInterpolationAngularVelocity(in[5]);
+            rigid_body->clearForces();
+
+            if (rigid_body->getMotionState())
+                rigid_body->getMotionState()->setWorldTransform(transform);
+
+            rigid_body->activate(true);
+        }
+
+        in += kRigidSize;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,293 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include <BulletSoftBody/btSoftBody.h>
+
+#include <cinder/Timer.h>
+#include <cinder/CinderMath.h>
+
+#include <inc/inc_PhysicsThread.h>
+#include <inc/inc_PhysicsWorld.h>
+
+namespace inc {
+
+RenderState::RenderState() {
+    step = 0;
+    num_settled = 0;
+}
+
+const RenderState::Body* RenderState::find(const btCollisionObject* object) const {
+    std::map<const btCollisionObject*, int>::const_iterator it = 
+        index.find(object);
+
+    if (it == index.end())
+        return NULL;
+
+    return &bodies[it->second];
+}
+
+RenderStateBuffer::RenderStateBuffer() {
+    back_ = 0;
+    middle_ = 1;
+    front_ = 2;
+    fresh_ = false;
+}
+
+void RenderStateBuffer::publish() {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    std::swap(back_, middle_);
+    fresh_ = true;
+}
+
+bool RenderStateBuffer::acquire() {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    if (!fresh_)
+        return false;
+
+    std::swap(front_, middle_);
+    fresh_ = false;
+
+    return true;
+}
+
+PhysicsThread::PhysicsThread(PhysicsWorld* physics) : physics_(physics) {
+    quit_ = false;
+    running_ = false;
+    dirty_ = false;
+
+    time_step_ = 1.0f / 60.0f;
+    time_scale_ = 1.0f;
+    steps_ = 0;
+    steps_per_second_ = 0.0f;
+}
+
+PhysicsThread::~PhysicsThread() {
+    stop();
+}
+
+void PhysicsThread::start(float dt, float time_scale) {
+    if (running_)
+        return;
+
+    set_rate(dt, time_scale);
+
+    // the drawing has something to read before the first step
+    publish();
+
+    quit_ = false;
+    running_ = true;
+    thread_ = std::tr1::shared_ptr<boost::thread>(
+        new boost::thread(std::bind(&PhysicsThread::run, this)));
+}
+
+void PhysicsThread::stop() {
+    if (!running_)
+        return;
+
+    quit_ = true;
+    thread_->join();
+    thread_.reset();
+
+    running_ = false;
+    steps_per_second_ = 0.0f;
+
+    // anything posted after the last step
+    run_commands();
+}
+
+void PhysicsThread::set_rate(float dt, float time_scale) {
+    boost::mutex::scoped_lock lock(command_mutex_);
+
+    time_step_ = ci::math<float>::max(dt, 0.0001f);
+    time_scale_ = ci::math<float>::max(time_scale, 0.01f);
+}
+
+void PhysicsThread::post(const std::function<void ()>& fn) {
+    if (!running_) {
+        fn();
+        return;
+    }
+
+    boost::mutex::scoped_lock lock(command_mutex_);
+    commands_.push_back(fn);
+}
+
+void PhysicsThread::run_commands() {
+    while (true) {
+        std::function<void ()> fn;
+
+        {
+            boost::mutex::scoped_lock lock(command_mutex_);
+
+            if (commands_.empty())
+                return;
+
+            fn = commands_.front();
+            commands_.pop_front();
+        }
+
+        // not under command_mutex_, so a command can post another
+        fn();
+    }
+}
+
+void PhysicsThread::publish() {
+    RenderState& state = buffer_.back();
+    btCollisionObjectArray& objects = physics_->world()->getCollisionObjectArray();
+
+    int num_nodes = 0;
+
+    for (int i = 0; i < objects.size(); ++i) {
+        btSoftBody* soft_body = btSoftBody::upcast(objects[i]);
+
+        if (soft_body)
+            num_nodes += soft_body->m_nodes.size();
+    }
+
+    state.index.clear();
+    state.bodies.resize(objects.size());
+    state.positions.resize(num_nodes);
+    state.normals.resize(num_nodes);
+
+    int first = 0;
+
+    for (int i = 0; i < objects.size(); ++i) {
+        RenderState::Body& body = state.bodies[i];
+        btSoftBody* soft_body = btSoftBody::upcast(objects[i]);
+
+        body.first = first;
+        body.num_nodes = -1;
+        body.transform = objects[i]->getWorldTransform();
+        body.sleeping = objects[i]->getActivationState() == ISLAND_SLEEPING;
+
+        // a soft body's shape reports the bounds Bullet keeps for it
+        objects[i]->getCollisionShape()->getAabb(body.transform, 
+            body.aabb_min, body.aabb_max);
+
+        state.index[objects[i]] = i;
+
+        if (soft_body == NULL)
+            continue;
+
+        btSoftBody::tNodeArray& nodes = soft_body->m_nodes;
+        body.num_nodes = nodes.size();
+
+        for (int j = 0; j < nodes.size(); ++j) {
+            state.positions[first + j] = nodes[j].m_x;
+            state.normals[first + j] = nodes[j].m_n;
+        }
+
+        first += nodes.size();
+    }
+
+    state.step = steps_;
+
+    if (publish_)
+        publish_(state);
+
+    buffer_.publish();
+}
+
+void PhysicsThread::run() {
+    ci::Timer clock(true);
+
+    double next = clock.getSeconds();
+    double rate_start = next;
+    int rate_steps = 0;
+
+    while (!quit_) {
+        float dt, time_scale;
+
+        {
+            boost::mutex::scoped_lock lock(command_mutex_);
+            dt = time_step_;
+            time_scale = time_scale_;
+        }
+
+        {
+            boost::recursive_mutex::scoped_lock lock(world_mutex_);
+
+            run_commands();
+
+            bool moved = true;
+
+            if (step_)
+                moved = step_(dt);
+            else
+                physics_->step(dt);
+
+            if (moved) {
+                ++steps_;
+                ++rate_steps;
+            }
+
+            if (moved || dirty_) {
+                publish();
+                dirty_ = false;
+            }
+        }
+
+        double now = clock.getSeconds();
+
+        if (now - rate_start >= 1.0) {
+            steps_per_second_ = (float) (rate_steps / (now - rate_start));
+            rate_start = now;
+            rate_steps = 0;
+        }
+
+        // a step is due every dt / time_scale of wall clock. When a step
+        // takes longer than that the thread just runs flat out, and a long
+        // stall isn't caught up on afterwards, like SolidFactory::step_fixed
+        next += dt / time_scale;
+
+        if (now - next > 0.25)
+            next = now;
+
+        if (next > now) {
+            boost::this_thread::sleep(boost::posix_time::microseconds(
+                (boost::int64_t) ((next - now) * 1000000.0)));
+        }
+    }
+}
+
+PhysicsThread::Pause::Pause(PhysicsThread* thread) : thread_(NULL) {
+    if (thread == NULL || !thread->running())
+        return;
+
+    thread->world_mutex_.lock();
+    thread_ = thread;
+
+    // anything already posted comes first, an edit posted for a body that's
+    // about to be removed still finds it
+    thread_->run_commands();
+}
+
+PhysicsThread::Pause::~Pause() {
+    if (thread_ == NULL)
+        return;
+
+    thread_->dirty_ = true;
+    thread_->world_mutex_.unlock();
+}
+
+}
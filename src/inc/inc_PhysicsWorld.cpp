@@ -0,0 +1,407 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include <BulletSoftBody/btSoftBodyHelpers.h>
+#include <BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h>
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
+
+#include <cinder/app/App.h>
+
+#include <inc/inc_PhysicsWorld.h>
+#include <inc/inc_MeshWelder.h>
+
+namespace inc {
+
+SoftBodyParams::SoftBodyParams() {
+    kDF = 1;
+	kDP = 1.0f;
+    kDG = 1.0f;
+	kPR = 0.0f;
+    kMT = 0.75f;
+
+    sphere_kLST = 0.1;
+    sphere_kVST = 0.1;
+    sphere_kDF = 1;
+    sphere_kDP = 0.001;
+    sphere_kPR = 2500;
+    sphere_total_mass = 1000.0f;
+}
+
+void SoftBodyParams::apply_mesh(btSoftBody* soft_body) const {
+	soft_body->m_cfg.kDF = kDF;
+	soft_body->m_cfg.kDP = kDP; // no fun
+    soft_body->m_cfg.kDG = kDG; // no fun
+	soft_body->m_cfg.kPR = kPR;
+    soft_body->m_cfg.kMT = kMT; // pose rigiditiy
+}
+
+void SoftBodyParams::apply_sphere(btSoftBody* soft_body) const {
+    soft_body->m_materials[0]->m_kLST = sphere_kLST;
+    soft_body->m_materials[0]->m_kVST = sphere_kVST;
+	soft_body->m_cfg.kDF = sphere_kDF;
+	soft_body->m_cfg.kDP = sphere_kDP; // fun factor...
+	soft_body->m_cfg.kPR = sphere_kPR;
+
+    soft_body->setTotalMass(sphere_total_mass);
+
+    // the link constants are worked out from the material stiffness and 
+    // the node masses. updateConstants would also reset the rest lengths
+    soft_body->updateLinkConstants();
+}
+
+PhysicsWorld::PhysicsWorld(btBroadphaseInterface* broadphase,
+    btSoftBodySolver* soft_body_solver) {
+    gravity_ = 0.0f;
+    weld_tolerance_ = 0.0f;
+
+    collision_configuration_ = new btSoftBodyRigidBodyCollisionConfiguration();
+    dispatcher_ = new btCollisionDispatcher(collision_configuration_);
+
+    broadphase_ = broadphase != NULL ? broadphase : new btDbvtBroadphase();
+    soft_body_solver_ = soft_body_solver != NULL ? soft_body_solver : 
+        new btDefaultSoftBodySolver();
+
+    solver_ = new btSequentialImpulseConstraintSolver();
+
+    world_ = new btSoftRigidDynamicsWorld(dispatcher_, broadphase_, 
+        solver_, collision_configuration_, soft_body_solver_);
+
+    world_info_.m_broadphase = broadphase_;
+    world_info_.m_dispatcher = dispatcher_;
+    world_info_.m_sparsesdf.Initialize();
+
+    set_gravity(gravity_);
+}
+
+PhysicsWorld::~PhysicsWorld() {
+    // all the bodies should be removed by now
+    world_info_.m_sparsesdf.Reset();
+
+    for (std::map<SphereKey, btSoftBody*>::iterator it = 
+        sphere_templates_.begin(); it != sphere_templates_.end(); ++it)
+        delete it->second;
+
+    delete world_;
+    delete soft_body_solver_;
+    delete solver_;
+    delete dispatcher_;
+    delete broadphase_;
+    delete collision_configuration_;
+}
+
+void PhysicsWorld::set_gravity(float gravity) {
+    gravity_ = gravity;
+
+    world_->setGravity(btVector3(0, gravity_, 0));
+    world_info_.m_gravity = btVector3(0, gravity_, 0);
+}
+
+void PhysicsWorld::step(float dt) {
+    world_->stepSimulation(dt, 0, dt);
+}
+
+void PhysicsWorld::set_broadphase(btBroadphaseInterface* broadphase) {
+    btCollisionObjectArray& objects = world_->getCollisionObjectArray();
+
+    std::vector<short int> groups(objects.size(), 0);
+    std::vector<short int> masks(objects.size(), 0);
+
+    for (int i = 0; i < objects.size(); ++i) {
+        btBroadphaseProxy* proxy = objects[i]->getBroadphaseHandle();
+
+        if (proxy == NULL)
+            continue;
+
+        groups[i] = proxy->m_collisionFilterGroup;
+        masks[i] = proxy->m_collisionFilterMask;
+
+        broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(proxy, 
+            dispatcher_);
+        broadphase_->destroyProxy(proxy, dispatcher_);
+        objects[i]->setBroadphaseHandle(NULL);
+    }
+
+    delete broadphase_;
+
+    broadphase_ = broadphase;
+    world_->setBroadphase(broadphase_);
+    world_info_.m_broadphase = broadphase_;
+
+    for (int i = 0; i < objects.size(); ++i) {
+        btCollisionObject* obj = objects[i];
+        btVector3 obj_min;
+        btVector3 obj_max;
+
+        obj->getCollisionShape()->getAabb(obj->getWorldTransform(), 
+            obj_min, obj_max);
+
+        obj->setBroadphaseHandle(broadphase_->createProxy(obj_min, obj_max,
+            obj->getCollisionShape()->getShapeType(), obj, groups[i], masks[i],
+            dispatcher_, 0));
+    }
+}
+
+void PhysicsWorld::delete_constraints() {
+    while (world_->getNumConstraints()) {
+		btTypedConstraint* pc = world_->getConstraint(0);
+		world_->removeConstraint(pc);
+		delete pc;
+	}
+}
+
+btSoftBody* PhysicsWorld::create_soft_mesh(const ci::TriMesh& in_mesh,
+    ci::Vec3f scl, bool lock_base_vertices, bool pointed_up) {
+    // weld straight into the buffers Bullet reads: the welded vertices are
+    // packed xyz, so they go to CreateFromTriMesh without another copy
+    MeshWelder welder(weld_tolerance_);
+    std::vector<int> triangles;
+
+    welder.weld(in_mesh, triangles);
+
+    // every triangle was degenerate, or collapsed in the weld
+    if (triangles.empty()) {
+        ci::app::console() << "ERROR: no triangles left to make a soft body "
+            "from after welding" << std::endl;
+        return NULL;
+    }
+
+    const std::vector<ci::Vec3f>& welded = welder.vertices();
+
+#ifdef BT_USE_DOUBLE_PRECISION
+    std::vector<btScalar> vertices(welded.size() * 3);
+    for (size_t i = 0; i < welded.size(); ++i) {
+        vertices[i * 3] = welded[i].x;
+        vertices[i * 3 + 1] = welded[i].y;
+        vertices[i * 3 + 2] = welded[i].z;
+    }
+    const btScalar* vertex_data = vertices.data();
+#else
+    static_assert(sizeof(ci::Vec3f) == 3 * sizeof(btScalar), 
+        "ci::Vec3f must be packed xyz");
+    const btScalar* vertex_data = 
+        reinterpret_cast<const btScalar*>(welded.data());
+#endif
+        
+    btSoftBody* soft_body = btSoftBodyHelpers::CreateFromTriMesh(world_info_,
+        vertex_data, triangles.data(), (int) triangles.size() / 3, false);
+
+    soft_body->m_materials[0]->m_kLST = 0.1;
+    //soft_body->m_cfg.aeromodel = btSoftBody::eAeroModel::V_TwoSided;
+    params_.apply_mesh(soft_body);
+
+    soft_body->m_cfg.collisions |= btSoftBody::fCollision::VF_SS;
+
+    soft_body->scale(btVector3(scl.x, scl.y, scl.z));
+
+    // the anchors are the nodes within a tenth of the height of the base,
+    // found from the unscaled welded positions as the masses are set. 
+    // Node i was made from welded vertex i
+    float spread = (welder.max_y() - welder.min_y()) / 10.0f;
+    float base = pointed_up ? welder.min_y() : welder.max_y();
+    
+    for (int i = 0; i < soft_body->m_nodes.size(); ++i) {
+        float y = welded[i].y;
+        bool anchor = lock_base_vertices && 
+            y < base + spread && y > base - spread;
+
+        soft_body->setMass(i, anchor ? 0.0f : 1.0f);
+    }
+
+    world_->addSoftBody(soft_body);
+
+    return soft_body;
+}
+
+bool PhysicsWorld::SphereKey::operator<(const SphereKey& k) const {
+    for (int i = 0; i < 3; ++i) {
+        if (radius[i] != k.radius[i])
+            return radius[i] < k.radius[i];
+    }
+
+    return resolution < k.resolution;
+}
+
+btSoftBody* PhysicsWorld::sphere_template(const SphereKey& key) {
+    std::map<SphereKey, btSoftBody*>::iterator it = sphere_templates_.find(key);
+
+    if (it != sphere_templates_.end())
+        return it->second;
+
+    btSoftBody* sphere = btSoftBodyHelpers::CreateEllipsoid(world_info_,
+        btVector3(0, 0, 0), 
+        btVector3(key.radius[0], key.radius[1], key.radius[2]), 
+        key.resolution);
+
+    // the clusters are grouped by mass, so they're made after the settings
+    // like in a body made from scratch
+    params_.apply_sphere(sphere);
+    sphere->generateClusters(20);
+
+    sphere_templates_[key] = sphere;
+
+    return sphere;
+}
+
+btSoftBody* PhysicsWorld::create_soft_sphere(const btVector3& position,
+    const btVector3& radius, int resolution) {
+    SphereKey key = { { radius.x(), radius.y(), radius.z() }, resolution };
+    const btSoftBody* sphere = sphere_template(key);
+
+    int num_nodes = sphere->m_nodes.size();
+    btAlignedObjectArray<btVector3> x;
+    btAlignedObjectArray<btScalar> m;
+    x.resize(num_nodes);
+    m.resize(num_nodes);
+
+    for (int i = 0; i < num_nodes; ++i) {
+        const btSoftBody::Node& node = sphere->m_nodes[i];
+
+        x[i] = node.m_x + position;
+        m[i] = node.m_im > 0 ? 1 / node.m_im : 0;
+    }
+
+    btSoftBody* soft_body = new btSoftBody(&world_info_, num_nodes, 
+        num_nodes > 0 ? &x[0] : NULL, num_nodes > 0 ? &m[0] : NULL);
+
+    *soft_body->m_materials[0] = *sphere->m_materials[0];
+    btSoftBody::Material* material = soft_body->m_materials[0];
+
+    const btSoftBody::Node* base = num_nodes > 0 ? &sphere->m_nodes[0] : NULL;
+
+    for (int i = 0; i < sphere->m_links.size(); ++i) {
+        const btSoftBody::Link& link = sphere->m_links[i];
+
+        soft_body->appendLink(int(link.m_n[0] - base), int(link.m_n[1] - base),
+            material);
+    }
+
+    for (int i = 0; i < sphere->m_faces.size(); ++i) {
+        const btSoftBody::Face& face = sphere->m_faces[i];
+
+        soft_body->appendFace(int(face.m_n[0] - base), 
+            int(face.m_n[1] - base), int(face.m_n[2] - base), material);
+    }
+
+    // rest lengths and areas come out the same as the template's, a 
+    // translation doesn't change them
+    soft_body->updateConstants();
+    params_.apply_sphere(soft_body);
+
+    // same nodes in each cluster, but the frames are worked out again for
+    // the new position
+    for (int i = 0; i < sphere->m_clusters.size(); ++i) {
+        const btSoftBody::Cluster& cluster = *sphere->m_clusters[i];
+
+        btSoftBody::Cluster* copy = new(btAlignedAlloc(
+            sizeof(btSoftBody::Cluster), 16)) btSoftBody::Cluster();
+        copy->m_collide = cluster.m_collide;
+
+        for (int j = 0; j < cluster.m_nodes.size(); ++j)
+            copy->m_nodes.push_back(
+                &soft_body->m_nodes[int(cluster.m_nodes[j] - base)]);
+
+        soft_body->m_clusters.push_back(copy);
+    }
+
+    if (soft_body->m_clusters.size() > 0) {
+        soft_body->initializeClusters();
+        soft_body->updateClusters();
+        soft_body->m_clusterConnectivity = sphere->m_clusterConnectivity;
+    }
+
+    soft_body->m_cfg.collisions |= btSoftBody::fCollision::VF_SS;
+
+    world_->addSoftBody(soft_body);
+
+    return soft_body;
+}
+
+float PhysicsWorld::kinetic_energy(const btSoftBody& soft_body) {
+    const btSoftBody::tNodeArray& nodes = soft_body.m_nodes;
+
+    btScalar energy = 0;
+    btScalar mass = 0;
+
+    for (int i = 0; i < nodes.size(); ++i) {
+        // anchored nodes have an inverse mass of 0
+        if (nodes[i].m_im <= 0)
+            continue;
+
+        btScalar m = 1 / nodes[i].m_im;
+
+        energy += m * nodes[i].m_v.length2();
+        mass += m;
+    }
+
+    if (mass <= 0)
+        return 0.0f;
+
+    return (float) (0.5f * energy / mass);
+}
+
+std::tr1::shared_ptr<ci::TriMesh> PhysicsWorld::remove_mesh_duplicates(
+    const ci::TriMesh& mesh, float tolerance) {
+    return MeshWelder::weld(mesh, tolerance);
+}
+
+std::tr1::shared_ptr<std::vector<int> > PhysicsWorld::get_top_vertices(
+    const ci::TriMesh& mesh, bool pointed_up) {
+
+    std::vector<ci::Vec3f> vertices = mesh.getVertices();
+
+    if (vertices.empty())
+        return std::tr1::shared_ptr<std::vector<int> >(new std::vector<int>());
+
+    float top_height = vertices[0].y;
+    float bottom_height = vertices[0].y;
+
+    for (std::vector<ci::Vec3f>::const_iterator it = vertices.begin();
+        it != vertices.end(); ++it) {
+        if (it->y >= top_height)
+            top_height = it->y;
+
+        if (it->y <= bottom_height)
+            bottom_height = it->y;
+    }
+
+    float spread = (top_height - bottom_height) / 10.0f;
+
+    std::tr1::shared_ptr<std::vector<int> > indices = 
+        std::tr1::shared_ptr<std::vector<int> >(new std::vector<int>());
+
+    float ref_height;
+
+    if (pointed_up) 
+        ref_height = bottom_height;
+    else
+        ref_height = top_height;
+
+    for (int i = 0; i < vertices.size(); ++i) {
+        if (vertices[i].y < (ref_height + spread) &&
+            vertices[i].y > (ref_height - spread)) {
+            indices->push_back(i);
+        }
+    }
+
+    return indices;
+}
+
+}
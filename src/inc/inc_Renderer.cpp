@@ -60,6 +60,10 @@ Renderer::Renderer() {
     solids_top_color_ = ci::ColorA(1.0f, 1.0f, 1.0f, 1.0f);
     solids_line_color_ = ci::ColorA(1.0f, 1.0f, 1.0f, 1.0f);
     solids_line_thickness_ = 1.0f;
+
+    frustum_culling_ = true;
+    num_drawn_ = 0;
+    num_culled_ = 0;
 }
 
 Renderer::~Renderer() {
@@ -70,6 +74,8 @@ Renderer::~Renderer() {
 
 void Renderer::setup() {
     cam_light_ = std::tr1::shared_ptr<Light>(new CameraLight(0));
+
+    gradient_shader_.setup();
 }
 
 void Renderer::update() {
@@ -109,19 +115,43 @@ void Renderer::draw_lights() {
 }
 
 void Renderer::draw_objects() {
+    // the whole camera view, so it also holds for each tile of save_image
+    frustum_.set(Camera::instance().cam().getCamera());
+
+    num_drawn_ = 0;
+    num_culled_ = 0;
+
+    ci::AxisAlignedBox3f box;
+
     // Draw Solids
     SolidList& solids = Manager::instance().solids();
     for (SolidList::const_iterator it = solids.begin(); it != solids.end(); ++it) {
-        if ((*it)->visible())
-            (*it)->draw();
+        if (!(*it)->visible())
+            continue;
+
+        if (frustum_culling_ && (*it)->bounds(box) && !frustum_.intersects(box)) {
+            ++num_culled_;
+            continue;
+        }
+
+        (*it)->draw();
+        ++num_drawn_;
     }
 
     // Draw GraphicItems
     GraphicItemList& graphic_items = Manager::instance().graphic_items();
     for (GraphicItemList::const_iterator it = graphic_items.begin(); 
         it != graphic_items.end(); ++it) {
-        if ((*it)->visible())
-            (*it)->draw();
+        if (!(*it)->visible())
+            continue;
+
+        if (frustum_culling_ && (*it)->bounds(box) && !frustum_.intersects(box)) {
+            ++num_culled_;
+            continue;
+        }
+
+        (*it)->draw();
+        ++num_drawn_;
     }
 }
 
@@ -0,0 +1,409 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <inc/inc_SimulationRecorder.h>
+
+namespace inc {
+
+namespace {
+
+// header: "INCR", version, quantum, keyframe interval, body count, the node
+// count of each body. Then the steps, then the keyframe offsets, then the 
+// trailer: index offset, step count, "INCX"
+const char kMagic[4] = { 'I', 'N', 'C', 'R' };
+const char kEndMagic[4] = { 'I', 'N', 'C', 'X' };
+const unsigned int kVersion = 1;
+const int kTrailerSize = 16;
+
+void put_u32(std::vector<unsigned char>& out, unsigned int v) {
+    for (int i = 0; i < 4; ++i)
+        out.push_back((unsigned char) (v >> (8 * i)));
+}
+
+void put_u64(std::vector<unsigned char>& out, unsigned long long v) {
+    for (int i = 0; i < 8; ++i)
+        out.push_back((unsigned char) (v >> (8 * i)));
+}
+
+void put_varint(std::vector<unsigned char>& out, unsigned int v) {
+    while (v >= 0x80) {
+        out.push_back((unsigned char) (v | 0x80));
+        v >>= 7;
+    }
+
+    out.push_back((unsigned char) v);
+}
+
+// small negative changes stay small
+unsigned int zigzag(int v) {
+    return ((unsigned int) v << 1) ^ (unsigned int) (v >> 31);
+}
+
+int unzigzag(unsigned int v) {
+    return (int) (v >> 1) ^ -(int) (v & 1);
+}
+
+bool get_u32(std::istream& in, unsigned int& v) {
+    unsigned char bytes[4];
+
+    if (!in.read((char*) bytes, 4))
+        return false;
+
+    v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= (unsigned int) bytes[i] << (8 * i);
+
+    return true;
+}
+
+bool get_u64(std::istream& in, unsigned long long& v) {
+    unsigned char bytes[8];
+
+    if (!in.read((char*) bytes, 8))
+        return false;
+
+    v = 0;
+    for (int i = 0; i < 8; ++i)
+        v |= (unsigned long long) bytes[i] << (8 * i);
+
+    return true;
+}
+
+bool get_varint(std::streambuf* in, unsigned int& v) {
+    v = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        int c = in->sbumpc();
+
+        if (c == std::char_traits<char>::eof())
+            return false;
+
+        v |= (unsigned int) (c & 0x7f) << shift;
+
+        if ((c & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+int quantize(btScalar x, float quantum) {
+    double q = std::floor(x / quantum + 0.5);
+
+    // far outside any scene, but it keeps every change in range of an int
+    return (int) std::max(-1073741824.0, std::min(1073741823.0, q));
+}
+
+}
+
+SimulationRecorder::SimulationRecorder() {
+    quantum_ = 0.001f;
+    keyframe_interval_ = 60;
+
+    num_steps_ = 0;
+    file_quantum_ = quantum_;
+    file_keyframe_interval_ = keyframe_interval_;
+}
+
+SimulationRecorder::~SimulationRecorder() {
+    stop();
+}
+
+bool SimulationRecorder::start(const std::string& path, 
+    const std::vector<btSoftBody*>& bodies) {
+    stop();
+
+    file_.open(path.c_str(), std::ios::binary | std::ios::trunc);
+
+    if (!file_.is_open())
+        return false;
+
+    bodies_ = bodies;
+    num_steps_ = 0;
+    keyframes_.clear();
+
+    file_quantum_ = std::max(quantum_, 1e-6f);
+    file_keyframe_interval_ = std::max(keyframe_interval_, 1);
+
+    buffer_.clear();
+    buffer_.insert(buffer_.end(), kMagic, kMagic + 4);
+    put_u32(buffer_, kVersion);
+
+    unsigned int quantum_bits;
+    std::memcpy(&quantum_bits, &file_quantum_, 4);
+    put_u32(buffer_, quantum_bits);
+
+    put_u32(buffer_, (unsigned int) file_keyframe_interval_);
+    put_u32(buffer_, (unsigned int) bodies_.size());
+
+    int num_values = 0;
+
+    for (size_t i = 0; i < bodies_.size(); ++i) {
+        put_u32(buffer_, (unsigned int) bodies_[i]->m_nodes.size());
+        num_values += bodies_[i]->m_nodes.size() * 3;
+    }
+
+    previous_.assign(num_values, 0);
+
+    file_.write((const char*) &buffer_[0], buffer_.size());
+
+    return true;
+}
+
+void SimulationRecorder::record() {
+    if (!file_.is_open())
+        return;
+
+    bool keyframe = num_steps_ % file_keyframe_interval_ == 0;
+
+    if (keyframe)
+        keyframes_.push_back((unsigned long long) file_.tellp());
+
+    buffer_.clear();
+    size_t k = 0;
+
+    for (size_t i = 0; i < bodies_.size(); ++i) {
+        const btSoftBody::tNodeArray& nodes = bodies_[i]->m_nodes;
+
+        for (int j = 0; j < nodes.size(); ++j) {
+            const btVector3& p = nodes[j].m_x;
+            btScalar x[3] = { p.x(), p.y(), p.z() };
+
+            for (int c = 0; c < 3; ++c, ++k) {
+                int q = quantize(x[c], file_quantum_);
+
+                put_varint(buffer_, zigzag(keyframe ? q : q - previous_[k]));
+                previous_[k] = q;
+            }
+        }
+    }
+
+    if (!buffer_.empty())
+        file_.write((const char*) &buffer_[0], buffer_.size());
+
+    ++num_steps_;
+}
+
+void SimulationRecorder::stop() {
+    if (!file_.is_open())
+        return;
+
+    unsigned long long index = (unsigned long long) file_.tellp();
+
+    buffer_.clear();
+    put_u32(buffer_, (unsigned int) keyframes_.size());
+
+    for (size_t i = 0; i < keyframes_.size(); ++i)
+        put_u64(buffer_, keyframes_[i]);
+
+    put_u64(buffer_, index);
+    put_u32(buffer_, (unsigned int) num_steps_);
+    buffer_.insert(buffer_.end(), kEndMagic, kEndMagic + 4);
+
+    file_.write((const char*) &buffer_[0], buffer_.size());
+    file_.close();
+
+    bodies_.clear();
+}
+
+bool SimulationRecorder::records(const btSoftBody* body) {
+    return std::find(bodies_.begin(), bodies_.end(), body) != bodies_.end();
+}
+
+
+SimulationReplay::SimulationReplay() {
+    quantum_ = 1.0f;
+    keyframe_interval_ = 1;
+    num_steps_ = 0;
+    step_ = -1;
+}
+
+bool SimulationReplay::open(const std::string& path) {
+    close();
+
+    file_.open(path.c_str(), std::ios::binary);
+
+    if (!file_.is_open())
+        return false;
+
+    char magic[4];
+    unsigned int version, quantum_bits, interval, num_bodies;
+
+    if (!file_.read(magic, 4) || std::memcmp(magic, kMagic, 4) != 0 ||
+        !get_u32(file_, version) || version != kVersion ||
+        !get_u32(file_, quantum_bits) || !get_u32(file_, interval) ||
+        !get_u32(file_, num_bodies)) {
+        close();
+        return false;
+    }
+
+    std::memcpy(&quantum_, &quantum_bits, 4);
+    keyframe_interval_ = (int) interval;
+
+    int num_values = 0;
+
+    for (unsigned int i = 0; i < num_bodies; ++i) {
+        unsigned int size;
+
+        if (!get_u32(file_, size)) {
+            close();
+            return false;
+        }
+
+        body_sizes_.push_back((int) size);
+        num_values += (int) size * 3;
+    }
+
+    unsigned long long index;
+    unsigned int num_steps, num_keyframes;
+
+    file_.seekg(-kTrailerSize, std::ios::end);
+
+    if (!get_u64(file_, index) || !get_u32(file_, num_steps) ||
+        !file_.read(magic, 4) || std::memcmp(magic, kEndMagic, 4) != 0) {
+        close();
+        return false;
+    }
+
+    file_.seekg((std::streamoff) index);
+
+    if (!get_u32(file_, num_keyframes) || keyframe_interval_ <= 0 || 
+        !(quantum_ > 0) || num_keyframes != 
+        (num_steps + interval - 1) / interval) {
+        close();
+        return false;
+    }
+
+    keyframes_.resize(num_keyframes);
+
+    for (unsigned int i = 0; i < num_keyframes; ++i) {
+        if (!get_u64(file_, keyframes_[i])) {
+            close();
+            return false;
+        }
+    }
+
+    num_steps_ = (int) num_steps;
+    values_.assign(num_values, 0);
+    step_ = -1;
+
+    return true;
+}
+
+void SimulationReplay::close() {
+    if (file_.is_open())
+        file_.close();
+
+    file_.clear();
+
+    num_steps_ = 0;
+    step_ = -1;
+    body_sizes_.clear();
+    keyframes_.clear();
+    values_.clear();
+}
+
+bool SimulationReplay::matches(const std::vector<btSoftBody*>& bodies) {
+    if (bodies.size() != body_sizes_.size())
+        return false;
+
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        if (bodies[i]->m_nodes.size() != body_sizes_[i])
+            return false;
+    }
+
+    return true;
+}
+
+bool SimulationReplay::seek(int step) {
+    if (!file_.is_open() || step < 0 || step >= num_steps_)
+        return false;
+
+    int keyframe = step / keyframe_interval_;
+
+    // scrubbing forwards within the same keyframe carries on from here
+    if (step_ < 0 || step < step_ || step_ / keyframe_interval_ != keyframe) {
+        file_.clear();
+        file_.seekg((std::streamoff) keyframes_[keyframe]);
+        step_ = keyframe * keyframe_interval_;
+
+        if (!read_frame(true)) {
+            step_ = -1;
+            return false;
+        }
+    }
+
+    while (step_ < step) {
+        if (!read_frame(false)) {
+            step_ = -1;
+            return false;
+        }
+
+        ++step_;
+    }
+
+    return true;
+}
+
+bool SimulationReplay::read_frame(bool keyframe) {
+    std::streambuf* in = file_.rdbuf();
+
+    for (size_t i = 0; i < values_.size(); ++i) {
+        unsigned int v;
+
+        if (!get_varint(in, v))
+            return false;
+
+        values_[i] = keyframe ? unzigzag(v) : values_[i] + unzigzag(v);
+    }
+
+    return true;
+}
+
+bool SimulationReplay::apply(const std::vector<btSoftBody*>& bodies) {
+    if (step_ < 0 || !matches(bodies))
+        return false;
+
+    size_t k = 0;
+
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        btSoftBody::tNodeArray& nodes = bodies[i]->m_nodes;
+
+        for (int j = 0; j < nodes.size(); ++j, k += 3) {
+            btSoftBody::Node& node = nodes[j];
+
+            node.m_x = btVector3(values_[k] * quantum_, 
+                values_[k + 1] * quantum_, values_[k + 2] * quantum_);
+            node.m_q = node.m_x;
+            node.m_v = btVector3(0, 0, 0);
+            node.m_f = btVector3(0, 0, 0);
+        }
+
+        bodies[i]->updateNormals();
+        bodies[i]->updateBounds();
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,284 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include <BulletSoftBody/btSoftBodyInternals.h>
+
+#include <inc/inc_SoftCollider.h>
+
+namespace inc {
+
+namespace {
+
+bool key_less(const std::pair<unsigned int, int>& a, 
+    const std::pair<unsigned int, int>& b) {
+    return a.first < b.first;
+}
+
+}
+
+SoftCollider::Grid::Grid() {
+    step = -1;
+    cell_size = 1;
+}
+
+SoftCollider::SoftCollider() {
+    auto_hash_nodes_ = 64;
+    num_clusters_ = 20;
+
+    step_ = 0;
+    stamp_ = 0;
+}
+
+SoftCollider::Mode SoftCollider::set_mode(btSoftBody* body, Mode mode) {
+    if (mode == AUTO)
+        mode = body->m_nodes.size() > auto_hash_nodes_ ? HASHED : VERTEX_FACE;
+
+    // the rigid body collision bits are left alone
+    int flags = body->m_cfg.collisions & btSoftBody::fCollision::RVSmask;
+
+    if (mode == VERTEX_FACE) {
+        flags |= btSoftBody::fCollision::VF_SS;
+    } else if (mode == CLUSTERS) {
+        if (body->m_clusters.size() == 0)
+            body->generateClusters(num_clusters_);
+
+        flags |= btSoftBody::fCollision::CL_SS;
+    }
+
+    body->m_cfg.collisions = flags;
+    modes_[body] = mode;
+
+    return mode;
+}
+
+SoftCollider::Mode SoftCollider::mode(const btSoftBody* body) const {
+    std::map<const btSoftBody*, Mode>::const_iterator it = modes_.find(body);
+
+    return it != modes_.end() ? it->second : AUTO;
+}
+
+void SoftCollider::remove(const btSoftBody* body) {
+    modes_.erase(body);
+    grids_.erase(body);
+}
+
+bool SoftCollider::handles(const btSoftBody* a, const btSoftBody* b) const {
+    Mode mode_a = mode(a);
+    Mode mode_b = mode(b);
+
+    if (mode_a == HASHED || mode_b == HASHED)
+        return true;
+
+    // bodies that were never set keep Bullet's behaviour
+    if (mode_a == AUTO || mode_b == AUTO)
+        return false;
+
+    return (a->m_cfg.collisions & b->m_cfg.collisions & 
+        btSoftBody::fCollision::SVSmask) == 0;
+}
+
+void SoftCollider::collide(btSoftBody* a, btSoftBody* b) {
+    if (a == b)
+        return;
+
+    // as VF_SS
+    btScalar margin = a->getCollisionShape()->getMargin() + 
+        b->getCollisionShape()->getMargin();
+
+    collide_nodes(a, b, margin);
+    collide_nodes(b, a, margin);
+}
+
+unsigned int SoftCollider::key(int x, int y, int z) {
+    // the usual large primes, see Teschner et al. 2003. Two cells with the
+    // same key just give a few extra faces to test
+    return ((unsigned int) x * 73856093u) ^ ((unsigned int) y * 19349663u) ^
+        ((unsigned int) z * 83492791u);
+}
+
+int SoftCollider::cell(btScalar v, btScalar cell_size) {
+    return (int) std::floor(v / cell_size);
+}
+
+const SoftCollider::Grid& SoftCollider::grid(const btSoftBody* body) {
+    Grid& grid = grids_[body];
+
+    if (grid.step == step_)
+        return grid;
+
+    grid.step = step_;
+    grid.entries.clear();
+
+    const btSoftBody::tFaceArray& faces = body->m_faces;
+    int num_faces = faces.size();
+
+    if (num_faces == 0)
+        return grid;
+
+    // cells about the size of a face, so most faces touch one to eight
+    btScalar total = 0;
+
+    for (int i = 0; i < num_faces; ++i) {
+        btVector3 lo = faces[i].m_n[0]->m_x;
+        btVector3 hi = lo;
+
+        for (int j = 1; j < 3; ++j) {
+            lo.setMin(faces[i].m_n[j]->m_x);
+            hi.setMax(faces[i].m_n[j]->m_x);
+        }
+
+        btVector3 size = hi - lo;
+        total += size[size.maxAxis()];
+    }
+
+    grid.cell_size = btMax(total / num_faces, btScalar(0.0001));
+
+    for (int i = 0; i < num_faces; ++i) {
+        btVector3 lo = faces[i].m_n[0]->m_x;
+        btVector3 hi = lo;
+
+        for (int j = 1; j < 3; ++j) {
+            lo.setMin(faces[i].m_n[j]->m_x);
+            hi.setMax(faces[i].m_n[j]->m_x);
+        }
+
+        int x1 = cell(hi.x(), grid.cell_size);
+        int y1 = cell(hi.y(), grid.cell_size);
+        int z1 = cell(hi.z(), grid.cell_size);
+
+        for (int x = cell(lo.x(), grid.cell_size); x <= x1; ++x) {
+            for (int y = cell(lo.y(), grid.cell_size); y <= y1; ++y) {
+                for (int z = cell(lo.z(), grid.cell_size); z <= z1; ++z)
+                    grid.entries.push_back(std::make_pair(key(x, y, z), i));
+            }
+        }
+    }
+
+    std::sort(grid.entries.begin(), grid.entries.end());
+
+    return grid;
+}
+
+void SoftCollider::collide_nodes(btSoftBody* a, btSoftBody* b, 
+    btScalar margin) {
+    const Grid& faces_grid = grid(b);
+
+    if (faces_grid.entries.empty())
+        return;
+
+    btVector3 b_min, b_max;
+    b->getAabb(b_min, b_max);
+
+    btSoftBody::tNodeArray& nodes = a->m_nodes;
+    btSoftBody::tFaceArray& faces = b->m_faces;
+
+    if ((int) stamps_.size() < faces.size())
+        stamps_.resize(faces.size(), -1);
+
+    btScalar cell_size = faces_grid.cell_size;
+
+    for (int i = 0; i < nodes.size(); ++i) {
+        btSoftBody::Node& node = nodes[i];
+        const btVector3 o = node.m_x;
+        const btScalar m = margin + (o - node.m_q).length() * 2;
+
+        if (o.x() + m < b_min.x() || o.y() + m < b_min.y() || 
+            o.z() + m < b_min.z() || o.x() - m > b_max.x() ||
+            o.y() - m > b_max.y() || o.z() - m > b_max.z())
+            continue;
+
+        if (stamp_ == INT_MAX) {
+            std::fill(stamps_.begin(), stamps_.end(), -1);
+            stamp_ = 0;
+        }
+
+        ++stamp_;
+
+        int x1 = cell(o.x() + m, cell_size);
+        int y1 = cell(o.y() + m, cell_size);
+        int z1 = cell(o.z() + m, cell_size);
+
+        for (int x = cell(o.x() - m, cell_size); x <= x1; ++x) {
+            for (int y = cell(o.y() - m, cell_size); y <= y1; ++y) {
+                for (int z = cell(o.z() - m, cell_size); z <= z1; ++z) {
+                    unsigned int k = key(x, y, z);
+                    std::vector<std::pair<unsigned int, int> >::const_iterator
+                        it = std::lower_bound(faces_grid.entries.begin(), 
+                        faces_grid.entries.end(), std::make_pair(k, 0), 
+                        key_less);
+
+                    for (; it != faces_grid.entries.end() && it->first == k; 
+                        ++it) {
+                        if (stamps_[it->second] == stamp_)
+                            continue;
+
+                        stamps_[it->second] = stamp_;
+                        add_contact(a, b, node, faces[it->second], m);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// exactly as Bullet's CollideVF_SS, apart from skipping a node that's right
+// on the face, which would give a NaN normal
+void SoftCollider::add_contact(btSoftBody* a, btSoftBody* b, 
+    btSoftBody::Node& node, btSoftBody::Face& face, btScalar m) {
+    const btVector3 o = node.m_x;
+    btVector3 p;
+    btScalar d = SIMD_INFINITY;
+
+    ProjectOrigin(face.m_n[0]->m_x - o, face.m_n[1]->m_x - o,
+        face.m_n[2]->m_x - o, p, d);
+
+    if (d >= m * m || d <= 0)
+        return;
+
+    const btSoftBody::Node* n[] = { face.m_n[0], face.m_n[1], face.m_n[2] };
+    const btVector3 w = BaryCoord(n[0]->m_x, n[1]->m_x, n[2]->m_x, p + o);
+    const btScalar ma = node.m_im;
+    btScalar mb = BaryEval(n[0]->m_im, n[1]->m_im, n[2]->m_im, w);
+
+    if (n[0]->m_im <= 0 || n[1]->m_im <= 0 || n[2]->m_im <= 0)
+        mb = 0;
+
+    const btScalar ms = ma + mb;
+
+    if (ms <= 0)
+        return;
+
+    btSoftBody::SContact c;
+    c.m_normal = p / -btSqrt(d);
+    c.m_margin = m;
+    c.m_node = &node;
+    c.m_face = &face;
+    c.m_weights = w;
+    c.m_friction = btMax(a->m_cfg.kDF, b->m_cfg.kDF);
+    c.m_cfm[0] = ma / ms * a->m_cfg.kSHR;
+    c.m_cfm[1] = mb / ms * b->m_cfg.kSHR;
+
+    a->m_scontacts.push_back(c);
+}
+
+}
@@ -48,6 +48,8 @@
 #include <cinder/TriMesh.h>
 #include <cinder/Rand.h>
 #include <cinder/ObjLoader.h>
+#include <cinder/CinderMath.h>
+#include <cinder/Timer.h>
 
 #include <inc/inc_Solid.h>
 #include <inc/inc_GraphicItem.h>
@@ -58,6 +60,11 @@
 #include <inc/inc_MeshCreator.h>
 #include <inc/inc_Renderer.h>
 #include <inc/inc_Color.h>
+#include <inc/inc_TaskPool.h>
+#include <inc/inc_ParallelSoftBodySolver.h>
+#include <inc/inc_PhysicsWorld.h>
+#include <inc/inc_MeshWelder.h>
+#include <inc/inc_EmbeddedMesh.h>
 
 namespace inc {
 
@@ -103,6 +110,20 @@ void Solid::remove_force() {
     has_force_ = false;
 }
 
+void Solid::store_previous_state() {
+    // nothing here
+}
+
+void Solid::update_settle(float, float, float) {
+    // nothing here, Bullet puts rigid bodies to sleep by itself
+}
+
+void Solid::wake() {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    body_->activate(true);
+}
+
 void Solid::set_visible(bool vis) {
     visible_ = vis;
 }
@@ -129,7 +150,7 @@ bool Solid::detect_selection(ci::Ray r) {
     // bounding sphere of a sphere-shaped object is the sphere that 
     // contains the bounding box of the sphere (not just the sphere)
     body_->getCollisionShape()->getBoundingSphere(center, radius);
-    center += body_->getWorldTransform().getOrigin();
+    center += published_transform().getOrigin();
 
     // override the bullet sphere if possible
     if (graphic_item_->has_alternate_bounding_sphere())
@@ -143,6 +164,51 @@ bool Solid::detect_selection(ci::Ray r) {
     return D > 0;
 }
 
+btTransform Solid::published_transform() {
+    const RenderState* state = SolidFactory::instance().render_state();
+    const RenderState::Body* body = state != NULL ? state->find(body_) : NULL;
+
+    return body != NULL ? body->transform : body_->getWorldTransform();
+}
+
+bool Solid::aabb(btVector3& min, btVector3& max) {
+    const RenderState* state = SolidFactory::instance().render_state();
+
+    if (state != NULL) {
+        const RenderState::Body* body = state->find(body_);
+
+        // not published yet, and the thread may be moving it
+        if (body == NULL)
+            return false;
+
+        min = body->aabb_min;
+        max = body->aabb_max;
+
+        return true;
+    }
+
+    if (body_->getCollisionShape() == NULL)
+        return false;
+
+    // a soft body's bounds already take in where its nodes were before the
+    // last step, so they hold while drawing interpolates
+    body_->getCollisionShape()->getAabb(body_->getWorldTransform(), min, max);
+
+    return true;
+}
+
+bool Solid::bounds(ci::AxisAlignedBox3f& box) {
+    btVector3 min, max;
+
+    if (!aabb(min, max))
+        return false;
+
+    box = ci::AxisAlignedBox3f(ci::Vec3f(min.x(), min.y(), min.z()),
+        ci::Vec3f(max.x(), max.y(), max.z()));
+
+    return true;
+}
+
 // the force menu hooks into this
 ci::Vec3f* Solid::force_ptr() {
     return &force_;
@@ -163,20 +229,53 @@ void Solid::set_selected(bool s) {
 
 RigidSolid::RigidSolid(SolidGraphicItem* item, btRigidBody* body, btDynamicsWorld* world) 
     : Solid(item, body, world) {
+    has_previous_transform_ = false;
 }
 
 RigidSolid::~RigidSolid() {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    world_->removeRigidBody(rigid_body_ptr());
+
     if (rigid_body().getMotionState())
         delete rigid_body().getMotionState();
 
-    if (rigid_body().getCollisionShape())
-        delete rigid_body().getCollisionShape();
+    btCollisionShape* shape = rigid_body().getCollisionShape();
 
-    world_->removeRigidBody(rigid_body_ptr());
+    // shared shapes are deleted by the cache once the last body is gone
+    if (shape && !SolidFactory::instance().shape_cache().release(shape))
+        delete shape;
 }
 
 void RigidSolid::draw() {
-    ci::Matrix44f tf = ci::bullet::getWorldTransform(rigid_body_ptr());
+    ci::Matrix44f tf;
+    const RenderState* state = SolidFactory::instance().render_state();
+
+    // the physics thread may be writing the motion state, so while it runs
+    // only the published transform is read
+    if (state != NULL) {
+        const RenderState::Body* body = state->find(body_);
+
+        // added since the last publish, it's drawn from the next one
+        if (body == NULL)
+            return;
+
+        body->transform.getOpenGLMatrix(tf.m);
+    } else {
+        tf = ci::bullet::getWorldTransform(rigid_body_ptr());
+    }
+
+    if (has_previous_transform_ && SolidFactory::instance().interpolating()) {
+        const btTransform& current = rigid_body().getWorldTransform();
+        float alpha = SolidFactory::instance().interpolation_alpha();
+
+        btTransform interpolated;
+        interpolated.setOrigin(previous_transform_.getOrigin().lerp(
+            current.getOrigin(), alpha));
+        interpolated.setRotation(previous_transform_.getRotation().slerp(
+            current.getRotation(), alpha));
+        interpolated.getOpenGLMatrix(tf.m);
+    }
 
     glPushMatrix();
         glMultMatrixf(tf.m);
@@ -207,6 +306,30 @@ btRigidBody* RigidSolid::rigid_body_ptr() {
     return btRigidBody::upcast(body_);
 }
 
+void RigidSolid::store_previous_state() {
+    previous_transform_ = rigid_body().getWorldTransform();
+    has_previous_transform_ = true;
+}
+
+bool RigidSolid::aabb(btVector3& min, btVector3& max) {
+    if (!Solid::aabb(min, max))
+        return false;
+
+    // draw() puts the body between its last two transforms. The two boxes
+    // together are close enough for the small turn of one step
+    if (has_previous_transform_ && SolidFactory::instance().interpolating()) {
+        btVector3 previous_min, previous_max;
+
+        rigid_body().getCollisionShape()->getAabb(previous_transform_, 
+            previous_min, previous_max);
+
+        min.setMin(previous_min);
+        max.setMax(previous_max);
+    }
+
+    return true;
+}
+
 ci::Vec3f RigidSolid::position() {
     btVector3 origin = rigid_body().getWorldTransform().getOrigin();
 
@@ -216,13 +339,20 @@ ci::Vec3f RigidSolid::position() {
 
 
 
-SoftSolid::SoftSolid(SolidGraphicItem* item, btSoftBody* body, btDynamicsWorld* world) 
-    : Solid(item, body, world) {
+SoftSolid::SoftSolid(SolidGraphicItem* item, btSoftBody* body, btDynamicsWorld* world,
+    MaterialGroup group) : Solid(item, body, world), material_group_(group) {
+    settled_ = false;
+    settle_time_ = 0.0f;
+    kinetic_energy_ = 0.0f;
 }
 
 SoftSolid::~SoftSolid() {
+    // the physics thread can't be stepping the body as it's taken out
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     SolidFactory::instance().soft_dynamics_world()->removeSoftBody(
         soft_body_ptr());
+    SolidFactory::instance().soft_body_removed(soft_body_ptr());
 }
 
 void SoftSolid::draw() {
@@ -230,24 +360,118 @@ void SoftSolid::draw() {
 }
 
 void SoftSolid::save(Exporter& exporter) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     exporter.input_soft_solid(*this);
 }
 
 // TODO: actually set gravity
 void SoftSolid::set_gravity(float g) {
-    body_->activate();
+    wake();
 }
 
 void SoftSolid::set_force(ci::Vec3f vel) {
     has_force_ = true;
     force_ = vel;
+
+    wake();
+}
+
+void SoftSolid::update_settle(float dt, float energy, float dwell) {
+    if (settled_) {
+        // something moving has run into it, or Bullet's islands woke it
+        if (soft_body().isActive() || touching_dynamic_object())
+            wake();
+
+        return;
+    }
+
+    kinetic_energy_ = PhysicsWorld::kinetic_energy(soft_body());
+
+    if (has_force_ || kinetic_energy_ > energy) {
+        settle_time_ = 0.0f;
+        return;
+    }
+
+    settle_time_ += dt;
+
+    if (settle_time_ >= dwell)
+        settle();
+}
+
+void SoftSolid::settle() {
+    btSoftBody::tNodeArray& nodes = soft_body().m_nodes;
+
+    for (int i = 0; i < nodes.size(); ++i) {
+        nodes[i].m_v.setZero();
+        nodes[i].m_f.setZero();
+    }
+
+    soft_body().setActivationState(ISLAND_SLEEPING);
+
+    // Bullet only clears these in predictMotion, which a sleeping body 
+    // skips, so anything left from the last active step would wake it again
+    soft_body().m_scontacts.resize(0);
+    soft_body().m_rcontacts.resize(0);
+
+    settled_ = true;
+}
+
+bool SoftSolid::drawn_settled() {
+    const RenderState* state = SolidFactory::instance().render_state();
+
+    if (state == NULL)
+        return settled_;
+
+    const RenderState::Body* body = state->find(body_);
+
+    return body != NULL && body->sleeping;
+}
+
+void SoftSolid::wake() {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    settled_ = false;
+    settle_time_ = 0.0f;
+
+    soft_body().setActivationState(ACTIVE_TAG);
+    soft_body().setDeactivationTime(0.0f);
+}
+
+// while the body sleeps, the only contacts added are from active objects 
+// running into it, since pairs where both sides sleep aren't collided. 
+// Nothing clears them either, so each check takes what has arrived since
+// the last one
+bool SoftSolid::touching_dynamic_object() {
+    btSoftBody& sb = soft_body();
+
+    bool touching = sb.m_scontacts.size() > 0;
+
+    for (int i = 0; !touching && i < sb.m_rcontacts.size(); ++i) {
+        const btCollisionObject* obj = sb.m_rcontacts[i].m_cti.m_colObj;
+
+        if (obj != NULL && !obj->isStaticOrKinematicObject())
+            touching = true;
+    }
+
+    sb.m_scontacts.resize(0);
+    sb.m_rcontacts.resize(0);
+
+    return touching;
 }
 
 void SoftSolid::update() {
     if (!has_force_) 
         return;
 
-    soft_body().setVelocity(ci::bullet::toBulletVector3(force_));
+    btSoftBody* body = soft_body_ptr();
+    ci::Vec3f force = force_;
+
+    // removing the body runs anything still posted first, so it's still 
+    // there when this runs
+    SolidFactory::instance().post([body, force] () {
+        body->setVelocity(ci::bullet::toBulletVector3(force));
+    } );
     // check the timer, then 
 }
 
@@ -259,6 +483,38 @@ btSoftBody* SoftSolid::soft_body_ptr() {
     return btSoftBody::upcast(body_);
 }
 
+void SoftSolid::store_previous_state() {
+    btSoftBody::tNodeArray& nodes = soft_body().m_nodes;
+
+    previous_positions_.resize(nodes.size());
+
+    for (int i = 0; i < nodes.size(); ++i)
+        previous_positions_[i] = nodes[i].m_x;
+}
+
+const btAlignedObjectArray<btVector3>* SoftSolid::previous_positions() {
+    if (!SolidFactory::instance().interpolating())
+        return NULL;
+
+    // nodes can be appended after creation, in which case the stored
+    // positions are out of date until the next step
+    if (previous_positions_.size() != soft_body().m_nodes.size())
+        return NULL;
+
+    return &previous_positions_;
+}
+
+bool SoftSolid::aabb(btVector3& min, btVector3& max) {
+    if (!Solid::aabb(min, max))
+        return false;
+
+    // the cage's bounds, the fine surface can stick out past them
+    if (embedded_mesh_)
+        embedded_mesh_->expand_cage_bounds(min, max);
+
+    return true;
+}
+
 bool SoftSolid::detect_selection(ci::Ray r) {
     return graphic_item_->detect_selection(r);
 }
@@ -285,6 +541,8 @@ void SoftSolid::select() {
 }
 
 std::shared_ptr<ci::TriMesh> SoftSolid::get_mesh() {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     btSoftBody& sb = soft_body();
 
     int num_faces = sb.m_faces.size();
@@ -327,77 +585,718 @@ SolidFactory::SolidFactory() {
     Solid::allow_forces_ = false;
     Solid::allow_selection_ = false;
 
-    kDF_ = 1;
-	kDP_ = 1.0f;
-    kDG_ = 1.0f;
-	kPR_ = 0.0f;
-    kMT_ = 0.75f;
-
-    sphere_kLST_ = 0.1;
-    sphere_kVST_ = 0.1;
-    sphere_kDF_ = 1;
-    sphere_kDP_ = 0.001;
-    sphere_kPR_ = 2500;
-    sphere_total_mass_ = 1000.0f;
-
     draw_bullet_debug_ = false;
+
+    step_mode_ = FRAME_LOCKED;
+    fixed_time_step_ = 1.0f / 60.0f;
+    max_sub_steps_ = 10;
+    // FRAME_LOCKED advances 10 steps of 1/60 per frame, so at 60fps this
+    // runs at the same speed
+    time_scale_ = 10.0f;
+    physics_budget_ = 12.0f;
+    accumulator_ = 0.0;
+    interpolation_alpha_ = 1.0f;
+    last_sub_steps_ = 0;
+    time_step_ = 0.0;
+    last_time_ = 0.0;
+
+    num_threads_ = TaskPool::hardware_threads();
+    parallel_soft_bodies_ = true;
+    deterministic_ = true;
+
+    allow_settling_ = true;
+    settle_energy_ = 0.001f;
+    settle_time_ = 1.0f;
+    num_settled_ = 0;
+
+    step_settings_.gravity = gravity_;
+    step_settings_.allow_settling = allow_settling_;
+    step_settings_.settle_energy = settle_energy_;
+    step_settings_.settle_time = settle_time_;
+    thread_num_settled_ = 0;
+
+    simulate_cage_ = false;
+    cage_resolution_ = 16;
+
+    soft_collision_mode_ = SoftCollider::AUTO;
+    auto_hash_nodes_ = 64;
+
+    recording_ = false;
+    replaying_ = false;
+    replay_step_ = 0;
+    replay_num_steps_ = 0;
+    recording_name_ = "simulation";
+
+    physics_ = NULL;
+    physics_thread_ = NULL;
+    threaded_ = false;
+    physics_steps_per_second_ = 0.0f;
+    last_thread_steps_ = 0;
+
+    broadphase_type_ = AXIS_SWEEP;
+    world_size_ = 300.0f;
+    has_sweep_bounds_ = false;
+    sweep_capacity_ = 0;
+    broadphase_pairs_ = 0;
+    manifolds_ = 0;
+    objects_outside_ = 0;
 }
 
 void SolidFactory::setup() {
     init_physics();
+
+    timer_.start();
+    last_time_ = timer_.getSeconds();
 }
 
 void SolidFactory::init_physics() {
-    collision_configuration_ = new btSoftBodyRigidBodyCollisionConfiguration();
-    int max_proxies = 32766;
-    btVector3 world_aabb_min(-300,-300,-300);
-	btVector3 world_aabb_max(300,300,300);
-    broadphase_ = new btAxisSweep3(world_aabb_min, world_aabb_max, max_proxies);
-    soft_body_world_info_.m_broadphase = broadphase_;
-
-    dispatcher_ = new btCollisionDispatcher(collision_configuration_);
-    soft_body_world_info_.m_dispatcher = dispatcher_;
+    task_pool_ = new TaskPool(num_threads_);
+    soft_body_solver_ = new ParallelSoftBodySolver(*task_pool_);
+    soft_body_solver_->set_enabled(parallel_soft_bodies_);
+    soft_body_solver_->set_deterministic(deterministic_);
 
-    solver_ = new btSequentialImpulseConstraintSolver();
+    // the world owns the broadphase and the solver from here on
+    physics_ = new PhysicsWorld(create_broadphase(), soft_body_solver_);
 
-    dynamics_world_ = new btSoftRigidDynamicsWorld(dispatcher_, broadphase_, 
-        solver_, collision_configuration_);
+    if (deterministic_)
+        physics_->world()->getSolverInfo().m_solverMode &= ~SOLVER_RANDMIZE_ORDER;
 
-    dynamics_world_->setGravity(btVector3(0, gravity_, 0));
-    soft_body_world_info_.m_gravity = btVector3(0, gravity_, 0);
+    physics_->set_gravity(gravity_);
 
-    soft_body_world_info_.m_sparsesdf.Initialize();
+    // not started until it's switched on
+    physics_thread_ = new PhysicsThread(physics_);
+    physics_thread_->set_step_function([this] (float dt) { 
+        return step_threaded(dt); 
+    } );
+    physics_thread_->set_publish_function([this] (RenderState& state) {
+        state.num_settled = thread_num_settled_;
+    } );
 
     debug_draw_ = new DebugDraw();
     debug_draw_->setDebugMode(
         btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawConstraints);
         //btIDebugDraw::DBG_DrawAabb);
-    dynamics_world_->setDebugDrawer(debug_draw_);
+    physics_->world()->setDebugDrawer(debug_draw_);
 }
 
 void SolidFactory::update() {
-    if (gravity_ != last_gravity_) {
-        dynamics_world_->setGravity(btVector3(0, gravity_, 0));
-        soft_body_world_info_.m_gravity = btVector3(0, gravity_, 0);
-        update_object_gravity();
+    double now = timer_.getSeconds();
+    time_step_ = now - last_time_;
+    last_time_ = now;
+
+    profiler_.update_readout();
+    post_step_settings();
+
+    if (replaying_) {
+        // the bodies stay wherever the replay put them
+        interpolation_alpha_ = 1.0f;
+        last_sub_steps_ = 0;
 
-        last_gravity_ = gravity_;
+        return;
     }
 
-    dynamics_world_->stepSimulation(1.0f, 10);
-	
-    double now = ci::app::getElapsedSeconds();
-	double time_step_ = now - last_time_;
-	last_time_ = now;
+    if (physics_thread_->running()) {
+        // the thread does the stepping, settling and stats itself
+        physics_thread_->set_rate(fixed_time_step_, time_scale_);
+        physics_thread_->acquire_render_state();
+        num_settled_ = physics_thread_->render_state().num_settled;
+
+        int steps = physics_thread_->steps();
+        last_sub_steps_ = steps - last_thread_steps_;
+        last_thread_steps_ = steps;
+
+        physics_steps_per_second_ = physics_thread_->steps_per_second();
+        interpolation_alpha_ = 1.0f;
+
+        return;
+    }
+
+    profiler_.begin_frame();
+
+    apply_gravity_change();
+
+    if (broadphase_needs_rebuild()) {
+        PhysicsProfiler::Scope scope(profiler_, "rebuild broadphase");
+        rebuild_broadphase();
+    }
+
+    {
+        PhysicsProfiler::Scope scope(profiler_, "step");
+
+        if (!world_awake()) {
+            // everything has settled, nothing to do until something wakes
+            accumulator_ = 0.0;
+            interpolation_alpha_ = 1.0f;
+            last_sub_steps_ = 0;
+        } else if (step_mode_ == FRAME_LOCKED) {
+            physics_->world()->stepSimulation(1.0f, 10);
+            recorder_.record();
+            interpolation_alpha_ = 1.0f;
+            last_sub_steps_ = 10;
+        } else {
+            step_fixed(time_step_);
+        }
+    }
+
+    // the dwell is in simulated time, as on the physics thread. FRAME_LOCKED
+    // takes 10 of Bullet's default 1/60 steps
+    float simulated = step_mode_ == FRAME_LOCKED ? 10.0f / 60.0f :
+        last_sub_steps_ * ci::math<float>::max(fixed_time_step_, 0.0001f);
+
+    if (last_sub_steps_ > 0) {
+        PhysicsProfiler::Scope scope(profiler_, "settling");
+        num_settled_ = update_settling(simulated);
+    }
+
+    {
+        PhysicsProfiler::Scope scope(profiler_, "stats");
+        update_broadphase_stats();
+    }
+
+    profiler_.end_frame(physics_->world());
+}
+
+bool SolidFactory::step_threaded(float dt) {
+    profiler_.begin_frame();
+
+    apply_gravity_change();
+
+    if (broadphase_needs_rebuild()) {
+        PhysicsProfiler::Scope scope(profiler_, "rebuild broadphase");
+        rebuild_broadphase();
+    }
+
+    // unlike step(), a world where everything has settled isn't stepped
+    if (!world_awake()) {
+        profiler_.end_frame(physics_->world());
+        return false;
+    }
+
+    {
+        PhysicsProfiler::Scope scope(profiler_, "step");
+        physics_->step(dt);
+        recorder_.record();
+    }
+
+    {
+        PhysicsProfiler::Scope scope(profiler_, "settling");
+        thread_num_settled_ = update_settling(dt);
+    }
+
+    {
+        PhysicsProfiler::Scope scope(profiler_, "stats");
+        update_broadphase_stats();
+    }
+
+    profiler_.end_frame(physics_->world());
+
+    return true;
+}
+
+bool SolidFactory::adjust_threaded(bool threaded) {
+    // a replay writes the bodies from this thread
+    if (threaded && replaying_) {
+        threaded_ = false;
+        return false;
+    }
+
+    if (threaded) {
+        accumulator_ = 0.0;
+        last_thread_steps_ = physics_thread_->steps();
+        physics_thread_->start(fixed_time_step_, time_scale_);
+    } else {
+        physics_thread_->stop();
+        physics_steps_per_second_ = 0.0f;
+    }
+
+    return false;
+}
+
+const RenderState* SolidFactory::render_state() {
+    if (!physics_thread_->running())
+        return NULL;
+
+    return &physics_thread_->render_state();
+}
+
+void SolidFactory::post(const std::function<void ()>& fn) {
+    physics_thread_->post(fn);
+}
+
+void SolidFactory::post_step_settings() {
+    StepSettings settings;
+    settings.gravity = gravity_;
+    settings.allow_settling = allow_settling_;
+    settings.settle_energy = settle_energy_;
+    settings.settle_time = settle_time_;
+
+    // run right away if the thread isn't running
+    post([this, settings] () { step_settings_ = settings; } );
+}
+
+void SolidFactory::apply_gravity_change() {
+    float gravity = step_settings_.gravity;
+
+    if (gravity == last_gravity_)
+        return;
+
+    physics_->set_gravity(gravity);
+    apply_object_gravity(gravity);
+
+    last_gravity_ = gravity;
+}
+
+bool SolidFactory::world_awake() {
+    if (!step_settings_.allow_settling)
+        return true;
+
+    btCollisionObjectArray& objects = physics_->world()->getCollisionObjectArray();
+
+    for (int i = 0; i < objects.size(); ++i) {
+        if (!objects[i]->isStaticOrKinematicObject() && objects[i]->isActive())
+            return true;
+    }
+
+    return false;
+}
+
+int SolidFactory::update_settling(float dt) {
+    if (!step_settings_.allow_settling)
+        return 0;
+
+    int num_settled = 0;
+
+    SolidList& solid_list = Manager::instance().solids();
+    for (SolidList::const_iterator it = solid_list.begin();
+        it != solid_list.end(); ++it) {
+        (*it)->update_settle(dt, step_settings_.settle_energy, 
+            step_settings_.settle_time);
+
+        if ((*it)->settled())
+            ++num_settled;
+    }
+
+    return num_settled;
+}
+
+void SolidFactory::wake_all_solids() {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    SolidList& solid_list = Manager::instance().solids();
+    for (SolidList::const_iterator it = solid_list.begin();
+        it != solid_list.end(); ++it) {
+        (*it)->wake();
+    }
+}
+
+void SolidFactory::save_snapshot() {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    snapshot_.capture(physics_->world());
+}
+
+bool SolidFactory::restore_snapshot() {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    if (!snapshot_.restore(physics_->world()))
+        return false;
+
+    // nothing should settle, or interpolate, from before the restore
+    wake_all_solids();
+    store_previous_states();
+    accumulator_ = 0.0;
+
+    return true;
+}
+
+bool SolidFactory::save_snapshot_button(bool) {
+    save_snapshot();
+
+    return false;
+}
+
+bool SolidFactory::restore_snapshot_button(bool) {
+    restore_snapshot();
+
+    return false;
+}
+
+std::vector<btSoftBody*> SolidFactory::recorded_bodies() {
+    btSoftBodyArray& bodies = soft_dynamics_world()->getSoftBodyArray();
+
+    std::vector<btSoftBody*> recorded;
+    recorded.reserve(bodies.size());
+
+    for (int i = 0; i < bodies.size(); ++i)
+        recorded.push_back(bodies[i]);
+
+    return recorded;
+}
+
+bool SolidFactory::adjust_recording(bool record) {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    if (!record) {
+        recorder_.stop();
+        return false;
+    }
+
+    if (replaying_ || 
+        !recorder_.start(recording_name_ + ".increc", recorded_bodies()))
+        recording_ = false;
+
+    return false;
+}
+
+bool SolidFactory::adjust_replaying(bool replay) {
+    if (!replay) {
+        replay_.close();
+        replay_num_steps_ = 0;
+
+        // carry on simulating from the step that was showing
+        wake_all_solids();
+        store_previous_states();
+        accumulator_ = 0.0;
+
+        return false;
+    }
+
+    if (physics_thread_->running()) {
+        physics_thread_->stop();
+        threaded_ = false;
+        physics_steps_per_second_ = 0.0f;
+    }
+
+    // the recording would pick up the replayed steps
+    recorder_.stop();
+    recording_ = false;
+
+    if (!replay_.open(recording_name_ + ".increc") || 
+        !replay_.matches(recorded_bodies())) {
+        replay_.close();
+        replaying_ = false;
+
+        return false;
+    }
+
+    replay_num_steps_ = replay_.num_steps();
+    replay_step_ = 0;
+    show_replay_step(replay_step_);
+
+    return false;
+}
+
+bool SolidFactory::adjust_replay_step(int step) {
+    replay_step_ = ci::math<int>::clamp(step, 0, 
+        ci::math<int>::max(replay_num_steps_ - 1, 0));
+
+    show_replay_step(replay_step_);
+
+    return false;
+}
+
+bool SolidFactory::show_replay_step(int step) {
+    if (!replaying_ || !replay_.seek(step))
+        return false;
+
+    if (!replay_.apply(recorded_bodies()))
+        return false;
+
+    replay_step_ = step;
+
+    // settled bodies are drawn from a display list of where they were
+    wake_all_solids();
+
+    return true;
+}
+
+void SolidFactory::soft_body_removed(btSoftBody* body) {
+    soft_collider().remove(body);
+
+    // the recorder would go on reading the freed nodes
+    if (recorder_.records(body)) {
+        recorder_.stop();
+        recording_ = false;
+    }
+}
+
+bool SolidFactory::adjust_allow_settling(bool allow) {
+    if (!allow)
+        wake_all_solids();
+
+    return false;
+}
+
+void SolidFactory::step_fixed(double frame_time) {
+    float dt = ci::math<float>::max(fixed_time_step_, 0.0001f);
+    int max_steps = ci::math<int>::max(max_sub_steps_, 1);
+
+    // a long stall (dragging the window, a file dialog) shouldn't be caught
+    // up on afterwards
+    accumulator_ += ci::math<double>::min(frame_time, 0.25) * time_scale_;
+
+    ci::Timer budget_timer(true);
+    int steps = 0;
+
+    while (accumulator_ >= dt && steps < max_steps) {
+        store_previous_states();
+
+        physics_->step(dt);
+        recorder_.record();
+
+        accumulator_ -= dt;
+        ++steps;
+
+        if (step_mode_ == ADAPTIVE_STEP && 
+            budget_timer.getSeconds() * 1000.0 > physics_budget_)
+            break;
+    }
+
+    // whatever wasn't simulated this frame is dropped, so a heavy scene
+    // runs slower than real time instead of falling further behind
+    if (accumulator_ >= dt)
+        accumulator_ = fmod(accumulator_, (double) dt);
+
+    interpolation_alpha_ = (float) (accumulator_ / dt);
+    last_sub_steps_ = steps;
+}
+
+void SolidFactory::store_previous_states() {
+    SolidList& solid_list = Manager::instance().solids();
+    for (SolidList::const_iterator it = solid_list.begin();
+        it != solid_list.end(); ++it) {
+        (*it)->store_previous_state();
+    }
+}
+
+float SolidFactory::time_step() {
+    return (float) time_step_;
+}
+
+void SolidFactory::step(float dt) {
+    post_step_settings();
+    apply_gravity_change();
+
+    if (broadphase_needs_rebuild())
+        rebuild_broadphase();
+
+    store_previous_states();
+
+    physics_->step(dt);
+    recorder_.record();
+
+    time_step_ = dt;
+    interpolation_alpha_ = 1.0f;
+    last_sub_steps_ = 1;
+
+    num_settled_ = update_settling(dt);
+    update_broadphase_stats();
+}
+
+bool SolidFactory::adjust_num_threads(int n) {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    task_pool_->set_num_threads(n);
+    // the pool clamps to at least one thread
+    num_threads_ = task_pool_->num_threads();
+
+    return false;
+}
+
+bool SolidFactory::adjust_parallel_soft_bodies(bool p) {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    soft_body_solver_->set_enabled(p);
+
+    return false;
+}
+
+bool SolidFactory::adjust_deterministic(bool d) {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    soft_body_solver_->set_deterministic(d);
+
+    if (d)
+        physics_->world()->getSolverInfo().m_solverMode &= ~SOLVER_RANDMIZE_ORDER;
+
+    return false;
+}
+
+btBroadphaseInterface* SolidFactory::create_broadphase(int extra_objects) {
+    if (broadphase_type_ == DYNAMIC_TREE) {
+        has_sweep_bounds_ = false;
+        return new btDbvtBroadphase();
+    }
+
+    btVector3 half_size(world_size_, world_size_, world_size_);
+
+    sweep_min_ = -half_size;
+    sweep_max_ = half_size;
+
+    int num_objects = extra_objects + (physics_ == NULL ? 0 : 
+        physics_->world()->getNumCollisionObjects());
+
+    if (broadphase_type_ == AUTO_SWEEP && scene_bounds(sweep_min_, sweep_max_)) {
+        // leave room for things to move before the next refit
+        btVector3 padding = (sweep_max_ - sweep_min_) * 0.5f + 
+            btVector3(50, 50, 50);
+
+        sweep_min_ -= padding;
+        sweep_max_ += padding;
+    }
+
+    has_sweep_bounds_ = true;
+
+    // a sweep can't grow, so there's room for as many objects again before
+    // broadphase_needs_rebuild asks for a bigger one
+    int capacity = std::max(num_objects * 2, 16384);
+
+    // btAxisSweep3 tops out at 32766 proxies
+    if (capacity > 32766) {
+        sweep_capacity_ = capacity;
+        return new bt32BitAxisSweep3(sweep_min_, sweep_max_, capacity);
+    }
+
+    sweep_capacity_ = 32766;
+
+    return new btAxisSweep3(sweep_min_, sweep_max_, 32766);
+}
+
+bool SolidFactory::scene_bounds(btVector3& scene_min, btVector3& scene_max) {
+    if (physics_ == NULL)
+        return false;
+
+    btCollisionObjectArray& objects = physics_->world()->getCollisionObjectArray();
+    bool found = false;
+
+    for (int i = 0; i < objects.size(); ++i) {
+        btVector3 obj_min;
+        btVector3 obj_max;
+
+        objects[i]->getCollisionShape()->getAabb(objects[i]->getWorldTransform(),
+            obj_min, obj_max);
+
+        // planes and other unbounded shapes
+        if (obj_max.distance2(obj_min) > BT_LARGE_FLOAT)
+            continue;
+
+        if (!found) {
+            scene_min = obj_min;
+            scene_max = obj_max;
+            found = true;
+        } else {
+            scene_min.setMin(obj_min);
+            scene_max.setMax(obj_max);
+        }
+    }
+
+    return found;
+}
+
+// the new broadphase is fitted to the scene as it is now, see 
+// PhysicsWorld::set_broadphase
+void SolidFactory::rebuild_broadphase(int extra_objects) {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    physics_->set_broadphase(create_broadphase(extra_objects));
+
+    objects_outside_ = 0;
+}
+
+bool SolidFactory::broadphase_needs_rebuild() {
+    if (!has_sweep_bounds_)
+        return false;
+
+    // rebuilt well before it's full, as bodies are added between steps
+    if (physics_->world()->getNumCollisionObjects() * 4 > sweep_capacity_ * 3)
+        return true;
+
+    return broadphase_type_ == AUTO_SWEEP && objects_outside_ > 0;
+}
+
+void SolidFactory::reserve_broadphase(int n) {
+    if (!has_sweep_bounds_)
+        return;
+
+    // handle 0 is the sweep's sentinel
+    if (physics_->world()->getNumCollisionObjects() + n < sweep_capacity_)
+        return;
+
+    rebuild_broadphase(n);
+}
+
+void SolidFactory::update_broadphase_stats() {
+    broadphase_pairs_ = physics_->broadphase()->getOverlappingPairCache()->
+        getNumOverlappingPairs();
+    manifolds_ = physics_->dispatcher()->getNumManifolds();
+
+    objects_outside_ = 0;
+
+    if (!has_sweep_bounds_)
+        return;
+
+    btCollisionObjectArray& objects = physics_->world()->getCollisionObjectArray();
+
+    for (int i = 0; i < objects.size(); ++i) {
+        btVector3 obj_min;
+        btVector3 obj_max;
+
+        objects[i]->getCollisionShape()->getAabb(objects[i]->getWorldTransform(),
+            obj_min, obj_max);
+
+        if (obj_max.distance2(obj_min) > BT_LARGE_FLOAT)
+            continue;
+
+        if (obj_min.x() < sweep_min_.x() || obj_min.y() < sweep_min_.y() || 
+            obj_min.z() < sweep_min_.z() || obj_max.x() > sweep_max_.x() ||
+            obj_max.y() > sweep_max_.y() || obj_max.z() > sweep_max_.z())
+            ++objects_outside_;
+    }
+}
+
+bool SolidFactory::adjust_broadphase_type(int) {
+    rebuild_broadphase();
+
+    return false;
+}
+
+bool SolidFactory::adjust_world_size(float) {
+    if (broadphase_type_ == AXIS_SWEEP)
+        rebuild_broadphase();
+
+    return false;
+}
+
+bool SolidFactory::rebuild_broadphase_button(bool) {
+    rebuild_broadphase();
+
+    return false;
+}
+
+bool SolidFactory::adjust_step_mode(int) {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    // the saved states belong to the old mode, so the first frame after
+    // the switch would interpolate from a stale pose
+    store_previous_states();
+    accumulator_ = 0.0;
+    interpolation_alpha_ = 1.0f;
+
+    return false;
 }
 
 void SolidFactory::draw() {
-    if (draw_bullet_debug_) {
-        Renderer::set_line_width(0.9f);
-        glBegin(GL_LINES);
-        dynamics_world_->debugDrawWorld();
-        glEnd();
+    if (!draw_bullet_debug_)
+        return;
+
+    {
+        PhysicsThread::Pause pause(physics_thread_);
+        physics_->world()->debugDrawWorld();
     }
+
+    // the lines are copies, so the thread can carry on while they're drawn
+    Renderer::set_line_width(0.9f);
+    debug_draw_->flush();
 }
 
 SolidFactory::~SolidFactory() {
@@ -409,26 +1308,25 @@ SolidFactory::~SolidFactory() {
     std::for_each(mesh_cleanup_.begin(), mesh_cleanup_.end(),
         [] (btTriangleMesh* ptr) { delete ptr; } );
 
-    soft_body_world_info_.m_sparsesdf.Reset();
-
+    // stops the thread before the world it steps goes
+    delete physics_thread_;
+    physics_thread_ = NULL;
+    // deletes the soft body solver, which uses the task pool
+    delete physics_;
     delete debug_draw_;
-    delete dynamics_world_;
-    delete solver_;
-    delete dispatcher_;
-    delete broadphase_;
-    delete collision_configuration_;
+    delete task_pool_;
 }
 
 void SolidFactory::delete_constraints() {
-    while (dynamics_world_->getNumConstraints()) {
-		btTypedConstraint* pc = dynamics_world_->getConstraint(0);
-		dynamics_world_->removeConstraint(pc);
-		delete pc;
-	}
+    PhysicsThread::Pause pause(physics_thread_);
+
+    physics_->delete_constraints();
 }
 
 SolidPtr SolidFactory::create_solid_box(ci::Vec3f dimensions, 
     ci::Vec3f position) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     btRigidBody* body = ci::bullet::createBox(SolidFactory::instance().dynamics_world(), 
         dimensions, ci::Quatf(), position);
 
@@ -442,6 +1340,8 @@ SolidPtr SolidFactory::create_solid_box(ci::Vec3f dimensions,
 
 SolidPtr SolidFactory::create_rigid_mesh(ci::TriMesh& mesh, 
     ci::Vec3f position, ci::Vec3f scale, float mass) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     // Create bullet object
     btConvexHullShape* shape = ci::bullet::createConvexHullShape(mesh, scale);
 
@@ -466,6 +1366,8 @@ SolidPtr SolidFactory::create_rigid_mesh(ci::TriMesh& mesh,
 
 SolidPtr SolidFactory::create_plane(ci::Vec3f dimension,
     ci::Vec3f position) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     // make a ground plane that cannot be moved
     btCollisionShape * groundShape	= new btStaticPlaneShape(
         btVector3(0,1,0),1);
@@ -489,7 +1391,11 @@ SolidPtr SolidFactory::create_plane(ci::Vec3f dimension,
 
 SolidPtr SolidFactory::create_static_solid_box(ci::Vec3f dimensions, 
     ci::Vec3f position) {
-    btCollisionShape* box = new btBoxShape(
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    CollisionShapeCache& cache = SolidFactory::instance().shape_cache();
+
+    btCollisionShape* box = cache.acquire_box(
         ci::bullet::toBulletVector3(dimensions) / 2.0f);
 
 	btDefaultMotionState* motion_state = 
@@ -497,9 +1403,8 @@ SolidPtr SolidFactory::create_static_solid_box(ci::Vec3f dimensions,
         btTransform(ci::bullet::toBulletQuaternion(ci::Quatf()),
         ci::bullet::toBulletVector3(position)));
 		
-	btVector3 inertia(0,0,0);
 	float mass = 0.0f; // objects of mass 0 do not move
-	box->calculateLocalInertia(mass, inertia);
+	btVector3 inertia = cache.local_inertia(box, mass);
 	btRigidBody::btRigidBodyConstructionInfo rigidBodyCI(mass, motion_state, 
         box, inertia);
 		
@@ -515,6 +1420,8 @@ SolidPtr SolidFactory::create_static_solid_box(ci::Vec3f dimensions,
 }
 
 RigidSolidPtr SolidFactory::create_rigid_sphere(ci::Vec3f position, ci::Vec3f radius) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     btRigidBody* body = create_bullet_rigid_sphere(position, radius.x);
 
     RigidSolidPtr solid(new RigidSolid(new SphereGraphicItem(radius.x), body, 
@@ -523,98 +1430,86 @@ RigidSolidPtr SolidFactory::create_rigid_sphere(ci::Vec3f position, ci::Vec3f ra
     return solid;
 }
 
-float SolidFactory::kDF_;
-float SolidFactory::kDP_;
-float SolidFactory::kDG_;
-float SolidFactory::kPR_;
-float SolidFactory::kMT_;
-
-float SolidFactory::sphere_kLST_;
-float SolidFactory::sphere_kVST_;
-float SolidFactory::sphere_kDF_;
-float SolidFactory::sphere_kDP_;
-float SolidFactory::sphere_kPR_;
-float SolidFactory::sphere_total_mass_;
-
 // NOTE: this not only loads the mesh, it locks the bottom vertices
 SoftSolidPtr SolidFactory::create_soft_mesh(std::tr1::shared_ptr<ci::TriMesh> in_mesh,
     ci::Vec3f scl, bool lock_base_vertices) {
-    ci::TriMesh mesh_copy = *in_mesh; // TODO: remove this copy step
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
 
-    std::tr1::shared_ptr<ci::TriMesh> mesh_ptr = 
-        remove_mesh_duplicates(mesh_copy);
+    PhysicsWorld& physics = *instance().physics_;
+    bool pointed_up = MeshCreator::instance().is_pointed_up();
 
-    ci::TriMesh mesh; // mesh with duplicates removed
-    mesh = *mesh_ptr;
+    if (!instance().simulate_cage_) {
+        btSoftBody* soft_body = physics.create_soft_mesh(*in_mesh, scl,
+            lock_base_vertices, pointed_up);
 
-    btScalar* vertices = new float[mesh.getNumVertices() * 3];
+        if (soft_body == NULL)
+            return SoftSolidPtr();
 
-    int i = 0;
-    for (std::vector<ci::Vec3f>::const_iterator it = mesh.getVertices().begin();
-        it != mesh.getVertices().end(); ++it) { 
-        vertices[i] = it->x; ++i;
-        vertices[i] = it->y; ++i;
-        vertices[i] = it->z; ++i;
-    }
+        instance().apply_soft_collision(soft_body);
 
-    int* triangles = new int[mesh.getNumIndices()];
-        
-    i = 0;
-    for (std::vector<size_t>::const_iterator it = mesh.getIndices().begin();
-        it != mesh.getIndices().end(); ++it) {
-        triangles[i] = *it;
-        ++i;
+        return SoftSolidPtr(new SoftSolid(
+            new SoftBodyGraphicItem(soft_body, container_color_), 
+            soft_body, SolidFactory::instance().dynamics_world(), 
+            SoftSolid::MESH_MATERIAL));
     }
-        
-    btSoftBody* soft_body = btSoftBodyHelpers::CreateFromTriMesh(
-        SolidFactory::instance().soft_body_world_info(),
-        vertices, triangles, mesh.getNumTriangles(), false);
 
+    std::tr1::shared_ptr<ci::TriMesh> fine = MeshWelder::weld(*in_mesh,
+        physics.weld_tolerance_);
 
-    soft_body->m_materials[0]->m_kLST = 0.1;
-    //soft_body->m_cfg.aeromodel = btSoftBody::eAeroModel::V_TwoSided;
-	soft_body->m_cfg.kDF = kDF_;
-	soft_body->m_cfg.kDP = kDP_; // no fun
-    soft_body->m_cfg.kDG = kDG_; // no fun
-	soft_body->m_cfg.kPR = kPR_;
-    soft_body->m_cfg.kMT = kMT_; // pose rigiditiy
+    ci::Vec3f min, max;
+    const std::vector<ci::Vec3f>& vertices = fine->getVertices();
 
-    soft_body->m_cfg.collisions |= btSoftBody::fCollision::VF_SS;
-        
-    btMatrix3x3 m;
-    // This sets the axis, I think
-    //m.setEulerZYX(-M_PI / 2.0f, 0.0, 0.0);
-    m.setIdentity();
-    // This sets the origin / starting position
-    soft_body->scale(ci::bullet::toBulletVector3(scl));
-    //soft_body->transform(btTransform(m, 
-    //    ci::bullet::toBulletVector3(ci::Vec3f(0.0f, 50.0f, 0.0f))));
-    
-    for (int i = 0; i < soft_body->m_nodes.size(); ++i) {
-        soft_body->setMass(i, 1.0f);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (i == 0) {
+            min = max = vertices[i];
+            continue;
+        }
+
+        min.set(ci::math<float>::min(min.x, vertices[i].x), 
+            ci::math<float>::min(min.y, vertices[i].y), 
+            ci::math<float>::min(min.z, vertices[i].z));
+        max.set(ci::math<float>::max(max.x, vertices[i].x), 
+            ci::math<float>::max(max.y, vertices[i].y), 
+            ci::math<float>::max(max.z, vertices[i].z));
     }
 
-    if (lock_base_vertices) {
-        std::tr1::shared_ptr<std::vector<int> > anchors = get_top_vertices(mesh);
+    ci::Vec3f size = max - min;
+    float longest = ci::math<float>::max(size.x, 
+        ci::math<float>::max(size.y, size.z));
 
-        std::for_each(anchors->begin(), anchors->end(),
-            [soft_body] (int index) { soft_body->setMass(index, 0.0f); });
-    }
+    // cage vertices end up more than a cell apart, so with the cell at least
+    // the weld tolerance create_soft_mesh's own weld leaves them alone, and 
+    // node i is cage vertex i
+    float cell_size = ci::math<float>::max(
+        longest / ci::math<float>::max((float) instance().cage_resolution_, 1.0f),
+        physics.weld_tolerance_);
+
+    std::vector<int> fine_to_cage;
+    std::tr1::shared_ptr<ci::TriMesh> cage = EmbeddedMesh::decimate(*fine, 
+        cell_size, fine_to_cage);
 
-    SolidFactory::instance().soft_dynamics_world()->addSoftBody(soft_body);
+    btSoftBody* soft_body = physics.create_soft_mesh(*cage, scl,
+        lock_base_vertices, pointed_up);
+
+    if (soft_body == NULL)
+        return SoftSolidPtr();
+
+    instance().apply_soft_collision(soft_body);
 
     SoftSolidPtr solid(new SoftSolid(
         new SoftBodyGraphicItem(soft_body, container_color_), 
-        soft_body, SolidFactory::instance().dynamics_world()));
+        soft_body, SolidFactory::instance().dynamics_world(), 
+        SoftSolid::MESH_MATERIAL));
 
-    delete [] triangles;
-    delete [] vertices;
+    solid->set_embedded_mesh(std::tr1::shared_ptr<EmbeddedMesh>(
+        new EmbeddedMesh(*fine, fine_to_cage, soft_body, scl)));
     
     return solid;
 }
 
 SoftSolidPtr SolidFactory::create_soft_container_from_convex_hull(
     std::tr1::shared_ptr<std::vector<ci::Vec3f>> points, bool lock_base_vertices) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
 
 	btAlignedObjectArray<btVector3>	pts;
 
@@ -627,11 +1522,7 @@ SoftSolidPtr SolidFactory::create_soft_container_from_convex_hull(
 
     soft_body->m_materials[0]->m_kLST = 0.1;
     //soft_body->m_cfg.aeromodel = btSoftBody::eAeroModel::V_TwoSided;
-	soft_body->m_cfg.kDF = kDF_;
-	soft_body->m_cfg.kDP = kDP_; // no fun
-    soft_body->m_cfg.kDG = kDG_; // no fun
-	soft_body->m_cfg.kPR = kPR_;
-    soft_body->m_cfg.kMT = kMT_; // pose rigiditiy
+    apply_mesh_params(soft_body);
 
     for (int i = 0; i < soft_body->m_nodes.size(); ++i) {
         soft_body->setMass(i, 1.0f);
@@ -652,23 +1543,27 @@ SoftSolidPtr SolidFactory::create_soft_container_from_convex_hull(
 
     SoftSolidPtr solid(new SoftSolid(
         new SoftBodyGraphicItem(soft_body, container_color_), 
-        soft_body, SolidFactory::instance().dynamics_world()));
+        soft_body, SolidFactory::instance().dynamics_world(),
+        SoftSolid::MESH_MATERIAL));
 
     return solid;
 }
 
 SoftSolidPtr SolidFactory::create_soft_sphere(ci::Vec3f position, ci::Vec3f radius) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     btSoftBody*	soft_body = create_bullet_soft_sphere(position, radius, 100);
 
     SoftSolidPtr solid(new SoftSolid(new SoftBodyGraphicItem(soft_body,
         sphere_color_), soft_body, 
-        SolidFactory::instance().dynamics_world()));
+        SolidFactory::instance().dynamics_world(), SoftSolid::SPHERE_MATERIAL));
 
     return solid;
 }
 
 std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_linked_soft_spheres(
     ci::Vec3f position, ci::Vec3f radius) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
 
     ci::Vec3f offset = ci::Vec3f(0.0f, radius.x * 1.1f, 0.0f);
 
@@ -687,16 +1582,19 @@ std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_linked_soft_sph
 
     d_ptr->push_back(SolidPtr(new SoftSolid(
         new SoftBodyGraphicItem(sb1, sphere_color_), sb1, 
-        SolidFactory::instance().dynamics_world())));
+        SolidFactory::instance().dynamics_world(), SoftSolid::SPHERE_MATERIAL)));
     d_ptr->push_back(SolidPtr(new SoftSolid(
         new SoftBodyGraphicItem(sb2, sphere_color_), sb2, 
-        SolidFactory::instance().dynamics_world())));
+        SolidFactory::instance().dynamics_world(), SoftSolid::SPHERE_MATERIAL)));
 
     return d_ptr;
 }
 
 std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_soft_sphere_matrix(
     ci::Vec3f position, ci::Vec3f radius, int w, int h, int d) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    instance().reserve_broadphase(w * h * d);
 
     std::vector<std::vector<std::vector<btSoftBody*> > > s_bodies;
     std::vector<std::vector<std::vector<ci::Vec3f> > > positions;
@@ -743,7 +1641,8 @@ std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_soft_sphere_mat
 
                 d_ptr->push_back(SolidPtr(new SoftSolid(
                     new SoftBodyGraphicItem(s_bodies[i][j][k],sphere_color_), 
-                    s_bodies[i][j][k], SolidFactory::instance().dynamics_world())));
+                    s_bodies[i][j][k], SolidFactory::instance().dynamics_world(),
+                    SoftSolid::SPHERE_MATERIAL)));
             }
         }
     }
@@ -785,6 +1684,9 @@ std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_soft_sphere_mat
 
 std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_rigid_sphere_matrix(
     ci::Vec3f position, ci::Vec3f radius, int w, int h, int d) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    instance().reserve_broadphase(w * h * d);
 
     std::vector<std::vector<std::vector<btRigidBody*> > > r_bodies;
     std::vector<std::vector<std::vector<ci::Vec3f> > > positions;
@@ -834,6 +1736,9 @@ std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_rigid_sphere_ma
 
 std::tr1::shared_ptr<std::deque<SolidPtr> > SolidFactory::create_rigid_sphere_spring_matrix(
     ci::Vec3f position, ci::Vec3f radius, int w, int h, int d) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
+    instance().reserve_broadphase(w * h * d);
 
     std::vector<std::vector<std::vector<btRigidBody*> > > r_bodies;
     std::vector<std::vector<std::vector<ci::Vec3f> > > positions;
@@ -953,20 +1858,21 @@ void SolidFactory::spring_link_rigid_spheres(btRigidBody* r1, btRigidBody* r2,
     spring->setEquilibriumPoint();
 }
 
-// N.B. see note in BasicDemo.cpp line 143 on how to increase performance of these
-// spheres by reusing a collision shape
+// spheres of the same radius share one collision shape, as in BasicDemo.cpp
 btRigidBody* SolidFactory::create_bullet_rigid_sphere(ci::Vec3f position, float radius) {
-        
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     ci::Quatf rotation = ci::Quatf::identity();
 
-    btCollisionShape* sphere = new btSphereShape((btScalar) radius);
+    CollisionShapeCache& cache = SolidFactory::instance().shape_cache();
+
+    btCollisionShape* sphere = cache.acquire_sphere(radius);
 	btDefaultMotionState* motion_state = new btDefaultMotionState(
         btTransform(ci::bullet::toBulletQuaternion(rotation),
         ci::bullet::toBulletVector3(position)));
 	
-	btVector3 inertia(0,0,0);
 	float mass = radius * radius * radius * PI * 4.0f/3.0f;
-	sphere->calculateLocalInertia(mass, inertia);
+	btVector3 inertia = cache.local_inertia(sphere, mass);
 	btRigidBody::btRigidBodyConstructionInfo rigid_body_ci(mass, motion_state, 
         sphere, inertia);
 	btRigidBody* rigid_body = new btRigidBody(rigid_body_ci);
@@ -982,13 +1888,11 @@ btRigidBody* SolidFactory::create_bullet_rigid_sphere(ci::Vec3f position, float
 // creates a soft sphere that tries to maintain a constant volume
 btSoftBody* SolidFactory::create_bullet_soft_sphere(ci::Vec3f position, 
     ci::Vec3f radius, float res) {
+    PhysicsThread::Pause pause(SolidFactory::instance().physics_thread());
+
     btVector3 pos = ci::bullet::toBulletVector3(position);
     btVector3 r = ci::bullet::toBulletVector3(radius);
 
-    btSoftBody* soft_body = btSoftBodyHelpers::CreateEllipsoid(
-        SolidFactory::instance().soft_body_world_info(),
-        pos, r, res);
-
     /*
     // volume based simulation
 	soft_body->m_cfg.kVC = 20;
@@ -997,40 +1901,61 @@ btSoftBody* SolidFactory::create_bullet_soft_sphere(ci::Vec3f position,
     soft_body->setPose(true,false);
     */
 
-    // pressure based simulation
-    soft_body->m_materials[0]->m_kLST = sphere_kLST_;
-    soft_body->m_materials[0]->m_kVST = sphere_kVST_;
-	soft_body->m_cfg.kDF = sphere_kDF_;
-	soft_body->m_cfg.kDP = sphere_kDP_; // fun factor...
-	soft_body->m_cfg.kPR = sphere_kPR_;
-
-    soft_body->setTotalMass(sphere_total_mass_);
-
-    soft_body->generateClusters(20);
+    // pressure based simulation, copied from a template sphere of the same
+    // size with the current sphere settings applied
+    btSoftBody* soft_body = instance().physics_->create_soft_sphere(pos, r, 
+        (int) res);
+    instance().apply_soft_collision(soft_body);
 
     // change these for different collision types (with other soft, with ridgid, with static...)
-    soft_body->m_cfg.collisions |= btSoftBody::fCollision::VF_SS;
     //soft_body->m_cfg.collisions = btSoftBody::fCollision::CL_SS + 
     //    btSoftBody::fCollision::CL_RS;
     //soft_body->m_cfg.collisions |= btSoftBody::fCollision::SDF_RS;
     //soft_body->m_cfg.collisions |= btSoftBody::fCollision::RVSmask;
     //soft_body->randomizeConstraints();
 
-    SolidFactory::instance().soft_dynamics_world()->addSoftBody(soft_body);
-
     return soft_body;
 }
 
+SoftCollider& SolidFactory::soft_collider() {
+    return soft_body_solver_->collider();
+}
+
+void SolidFactory::apply_soft_collision(btSoftBody* soft_body) {
+    SoftCollider& collider = soft_collider();
+
+    collider.auto_hash_nodes_ = auto_hash_nodes_;
+    collider.set_mode(soft_body, (SoftCollider::Mode) soft_collision_mode_);
+}
+
+bool SolidFactory::apply_soft_collision_button(bool) {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    SolidList& solid_list = Manager::instance().solids();
+    for (SolidList::const_iterator it = solid_list.begin();
+        it != solid_list.end(); ++it) {
+        SoftSolid* soft = dynamic_cast<SoftSolid*>(it->get());
+
+        if (soft == NULL || !soft->selected())
+            continue;
+
+        apply_soft_collision(soft->soft_body_ptr());
+        soft->wake();
+    }
+
+    return false;
+}
+
 btDynamicsWorld* SolidFactory::dynamics_world() {
-    return dynamics_world_;
+    return physics_->world();
 }
 
 btSoftRigidDynamicsWorld* SolidFactory::soft_dynamics_world() {
-    return dynamics_world_;
+    return physics_->world();
 }
 
 btSoftBodyWorldInfo& SolidFactory::soft_body_world_info() {
-    return soft_body_world_info_;
+    return physics_->world_info();
 }
 
 SolidFactory* SolidFactory::instance_;
@@ -1044,10 +1969,16 @@ SolidFactory* SolidFactory::instance_ptr() {
 }
 
 void SolidFactory::update_object_gravity() {
+    PhysicsThread::Pause pause(physics_thread_);
+
+    apply_object_gravity(gravity_);
+}
+
+void SolidFactory::apply_object_gravity(float gravity) {
     SolidList& solid_list = Manager::instance().solids();
     for (SolidList::const_iterator it =  solid_list.begin();
         it != solid_list.end(); ++it) {
-        (*it)->set_gravity(gravity_);
+        (*it)->set_gravity(gravity);
     }
 }
 
@@ -1065,171 +1996,147 @@ float* SolidFactory::gravity_ptr() {
     return &gravity_;
 }
 
-// yes, this method does actually work, it's needed for OBJ loading
-std::tr1::shared_ptr<ci::TriMesh> SolidFactory::remove_mesh_duplicates(
-    const ci::TriMesh& mesh) {
+bool SolidFactory::adjust_kDF(float) {
+    return physics_param_changed(SoftSolid::MESH_MATERIAL);
+}
 
-    std::vector<ci::Vec3f> vertices = mesh.getVertices();
-	std::vector<size_t> indices = mesh.getIndices();
+bool SolidFactory::adjust_kDP(float) {
+    return physics_param_changed(SoftSolid::MESH_MATERIAL);
+}
 
-    std::tr1::shared_ptr<ci::TriMesh> mesh_ptr = 
-        std::tr1::shared_ptr<ci::TriMesh>(new ci::TriMesh());
+bool SolidFactory::adjust_kDG(float) {
+    return physics_param_changed(SoftSolid::MESH_MATERIAL);
+}
 
-    std::vector<ci::Vec3f> vertex_reduce;
-    std::vector<ci::Vec3f>::const_iterator reduce_it;
+bool SolidFactory::adjust_kPR(float) {
+    return physics_param_changed(SoftSolid::MESH_MATERIAL);
+}
 
-    float thresh = 0.0000001;
+bool SolidFactory::adjust_kMT(float) {
+    return physics_param_changed(SoftSolid::MESH_MATERIAL);
+}
 
-    // NOTE: the threshhold code so far seems really buggy. The code as it stands now
-    // removes vertices, but only if they are exact float matches (a relative rarity).
-    // the "thresh" code checks distances, but removes a lot of vertices it shouldn't
-    bool use_thresh = false;
+bool SolidFactory::adjust_sphere_kLST(float) {
+    return physics_param_changed(SoftSolid::SPHERE_MATERIAL);
+}
 
-    std::map<ci::Vec3f, int> remove_index_map;
+bool SolidFactory::adjust_sphere_kVST(float) {
+    return physics_param_changed(SoftSolid::SPHERE_MATERIAL);
+}
 
-    for (std::vector<ci::Vec3f>::const_iterator it = vertices.begin();
-        it != vertices.end(); ++it) {
-        if (use_thresh) {
-            bool found = false;
-            int i = 0;
-            for (reduce_it = vertex_reduce.begin(); reduce_it != vertex_reduce.end();
-                ++reduce_it) {
-                if (it->distance(*reduce_it) < thresh) {
-                    found = true;
+bool SolidFactory::adjust_sphere_kDF(float) {
+    return physics_param_changed(SoftSolid::SPHERE_MATERIAL);
+}
 
-                    remove_index_map[*it] = i;
+bool SolidFactory::adjust_sphere_kDP(float) {
+    return physics_param_changed(SoftSolid::SPHERE_MATERIAL);
+}
 
-                    break;
-                }
-                ++i;
-            }
+bool SolidFactory::adjust_sphere_kPR(float) {
+    return physics_param_changed(SoftSolid::SPHERE_MATERIAL);
+}
 
-            if (found)
-                continue;
-        } else {
-            reduce_it = find(vertex_reduce.begin(), vertex_reduce.end(), *it);
-            if (reduce_it != vertex_reduce.end())
-                continue;
-        }
+bool SolidFactory::adjust_sphere_total_mass(float) {
+    return physics_param_changed(SoftSolid::SPHERE_MATERIAL);
+}
 
-        vertex_reduce.push_back(*it);
-        mesh_ptr->appendVertex(*it);
-    }
+void SolidFactory::apply_mesh_params(btSoftBody* soft_body) {
+    instance().physics_->params_.apply_mesh(soft_body);
+}
 
-    // algorithm to find the indice of the vector
-    auto find_indice = [&] (const std::vector<ci::Vec3f>& vec, 
-        ci::Vec3f val)->int {
-        
-        // first try looking if it was removed
-        if (use_thresh && remove_index_map.find(val) != remove_index_map.end())
-            return remove_index_map[val];
-
-        // otherwise we should have an exact match
-        for (int i = 0; i < vec.size(); ++i) {
-            if (vec[i] == val)
-                return i;
-        }
+void SolidFactory::apply_sphere_params(btSoftBody* soft_body) {
+    instance().physics_->params_.apply_sphere(soft_body);
+}
 
-        // oh no, this is not good...
-        return 0;
-    };
+bool SolidFactory::physics_param_changed(SoftSolid::MaterialGroup group) {
+    PhysicsThread::Pause pause(physics_thread_);
 
-    for (std::vector<size_t>::const_iterator it = indices.begin();
-        it != indices.end(); ) {
+    SolidList& solid_list = Manager::instance().solids();
+    for (SolidList::const_iterator it = solid_list.begin();
+        it != solid_list.end(); ++it) {
+        SoftSolid* soft = dynamic_cast<SoftSolid*>(it->get());
 
-        int in1, in2, in3;
+        if (soft == NULL || soft->material_group() != group)
+            continue;
 
-        in1 = find_indice(vertex_reduce, vertices[*it]); ++it;
-        in2 = find_indice(vertex_reduce, vertices[*it]); ++it;
-        in3 = find_indice(vertex_reduce, vertices[*it]); ++it;
+        if (group == SoftSolid::MESH_MATERIAL)
+            apply_mesh_params(soft->soft_body_ptr());
+        else if (group == SoftSolid::SPHERE_MATERIAL)
+            apply_sphere_params(soft->soft_body_ptr());
 
-        mesh_ptr->appendTriangle(in1, in2, in3);
+        soft->wake();
     }
 
-    return mesh_ptr;
+    return false;
 }
 
-std::tr1::shared_ptr<std::vector<int> > SolidFactory::get_top_vertices(
-    const ci::TriMesh& mesh) {
-
-    std::vector<ci::Vec3f> vertices = mesh.getVertices();
-
-    if (vertices.empty())
-        return std::tr1::shared_ptr<std::vector<int> >(new std::vector<int>());
-
-    float top_height = vertices[0].y;
-    float bottom_height = vertices[0].y;
-
-    for (std::vector<ci::Vec3f>::const_iterator it = vertices.begin();
-        it != vertices.end(); ++it) {
-        if (it->y >= top_height)
-            top_height = it->y;
-
-        if (it->y <= bottom_height)
-            bottom_height = it->y;
-    }
 
-    float spread = (top_height - bottom_height) / 10.0f;
 
-    std::tr1::shared_ptr<std::vector<int> > indices = 
-        std::tr1::shared_ptr<std::vector<int> >(new std::vector<int>());
+///////////////////////////////
+// DebugDraw
 
-    float ref_height;
+DebugDraw::DebugDraw() : mode_(DBG_NoDebug) {
+    max_lines_ = 200000;
+    decimation_ = 1;
+    lines_offered_ = 0;
+    lines_over_limit_ = 0;
+    lines_drawn_ = 0;
+    lines_dropped_ = 0;
+}
 
-    if (MeshCreator::instance().is_pointed_up()) 
-        ref_height = bottom_height;
-    else
-        ref_height = top_height;
+void DebugDraw::drawLine(const btVector3& from, const btVector3& to, 
+    const btVector3& color) {
+    if (decimation_ > 1 && lines_offered_++ % decimation_ != 0)
+        return;
 
-    for (int i = 0; i < vertices.size(); ++i) {
-        if (vertices[i].y < (ref_height + spread) &&
-            vertices[i].y > (ref_height - spread)) {
-            indices->push_back(i);
-        }
+    if ((int) vertices_.size() >= max_lines_ * 2) {
+        ++lines_over_limit_;
+        return;
     }
 
-    return indices;
-}
+    Vertex v;
 
-bool SolidFactory::adjust_kDF(float) {
-    return physics_param_changed();
-}
-
-bool SolidFactory::adjust_kDP(float) {
-    return physics_param_changed();
-}
+    v.color[0] = (GLubyte) (ci::math<float>::clamp(color.x()) * 255.0f + 0.5f);
+    v.color[1] = (GLubyte) (ci::math<float>::clamp(color.y()) * 255.0f + 0.5f);
+    v.color[2] = (GLubyte) (ci::math<float>::clamp(color.z()) * 255.0f + 0.5f);
+    v.color[3] = (GLubyte) (0.9f * 255.0f + 0.5f);
 
-bool SolidFactory::adjust_kDG(float) {
-    return physics_param_changed();
-}
+    v.position[0] = from.x();
+    v.position[1] = from.y();
+    v.position[2] = from.z();
+    vertices_.push_back(v);
 
-bool SolidFactory::adjust_kPR(float) {
-    return physics_param_changed();
+    v.position[0] = to.x();
+    v.position[1] = to.y();
+    v.position[2] = to.z();
+    vertices_.push_back(v);
 }
 
-bool SolidFactory::adjust_kMT(float) {
-    return physics_param_changed();
-}
+void DebugDraw::flush() {
+    lines_drawn_ = (int) vertices_.size() / 2;
+    lines_dropped_ = lines_over_limit_;
 
-bool SolidFactory::physics_param_changed() {
-    MeshCreator::instance().rebuild_mesh();
+    if (!vertices_.empty()) {
+        Color::begin_vertex_colors();
 
-    return false;
-}
+        glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
 
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(Vertex), vertices_[0].position);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), vertices_[0].color);
 
+        glDrawArrays(GL_LINES, 0, (GLsizei) vertices_.size());
 
-///////////////////////////////
-// DebugDraw
+        glPopClientAttrib();
 
-DebugDraw::DebugDraw() : mode_(DBG_NoDebug) {
-}
+        Color::end_vertex_colors();
+    }
 
-void DebugDraw::drawLine(const btVector3& from, const btVector3& to, 
-    const btVector3& color) {
-    Color::set_color_a(color.x(), color.y(), color.z(), 0.9f);
-    glVertex3f(from.x(), from.y(), from.z());
-    glVertex3f(to.x(), to.y(), to.z());
+    // the capacity is kept for the next frame
+    vertices_.clear();
+    lines_offered_ = 0;
+    lines_over_limit_ = 0;
 }
 
 void DebugDraw::drawContactPoint(const btVector3& PointOnB, 
@@ -0,0 +1,71 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cinder/CinderMath.h>
+
+#include <inc/inc_SplineSampler.h>
+
+namespace inc {
+
+SplineSampler::SplineSampler() {
+    // nothing here
+}
+
+bool SplineSampler::sample(std::tr1::shared_ptr<ci::BSpline3f> spline,
+    const std::vector<float>& params) {
+    if (spline.get() == NULL) {
+        clear();
+        return false;
+    }
+
+    if (spline == spline_ && params == params_)
+        return false;
+
+    spline_ = spline;
+    params_ = params;
+
+    int count = params_.size();
+
+    positions_.resize(count);
+
+    for (int i = 0; i < count; ++i)
+        positions_[i] = spline_->getPosition(params_[i]);
+
+    return true;
+}
+
+bool SplineSampler::sample_uniform(std::tr1::shared_ptr<ci::BSpline3f> spline,
+    int res) {
+    std::vector<float> params;
+
+    params.reserve(res);
+
+    for (int i = 0; i < res; ++i)
+        params.push_back(ci::lmap<float>(i, 0, res - 1, 0, 1.0f));
+
+    return sample(spline, params);
+}
+
+void SplineSampler::clear() {
+    spline_.reset();
+    params_.clear();
+    positions_.clear();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+
+#include <cinder/CinderMath.h>
+#include <cinder/Timer.h>
+
+#include <inc/inc_SweepDriver.h>
+#include <inc/inc_TaskPool.h>
+
+namespace inc {
+
+SweepDriver::SweepDriver() {
+    time_step_ = 1.0f / 60.0f;
+    max_steps_ = 100000;
+    settle_energy_ = 0.001f;
+    settle_time_ = 1.0f;
+    num_threads_ = 1;
+    weld_tolerance_ = 0.0f;
+}
+
+void SweepDriver::add_variant(const Variant& variant) {
+    variants_.push_back(variant);
+}
+
+void SweepDriver::add_grid(const SoftBodyParams& base, float gravity,
+    const std::vector<float>& pressures, const std::vector<float>& dampings) {
+    for (size_t i = 0; i < pressures.size(); ++i) {
+        for (size_t j = 0; j < dampings.size(); ++j) {
+            Variant variant;
+            variant.params = base;
+            variant.params.kPR = pressures[i];
+            variant.params.kDP = dampings[j];
+            variant.gravity = gravity;
+
+            add_variant(variant);
+        }
+    }
+}
+
+void SweepDriver::clear() {
+    variants_.clear();
+    results_.clear();
+}
+
+void SweepDriver::run(const ci::TriMesh& mesh, ci::Vec3f scl,
+    bool lock_base_vertices, bool pointed_up) {
+    results_.clear();
+    results_.resize(variants_.size());
+
+    int num_threads = can_run_threaded() ? num_threads_ : 1;
+
+    // a pool of our own, SolidFactory's is busy with the scene
+    TaskPool pool(num_threads);
+
+    // one world per job, the soft body step inside each stays single 
+    // threaded so the pool isn't used from inside itself
+    pool.parallel_for(0, (int) variants_.size(), [&] (int i) {
+        run_variant(i, mesh, scl, lock_base_vertices, pointed_up);
+    } );
+}
+
+bool SweepDriver::can_run_threaded() {
+#ifdef BT_NO_PROFILE
+    return true;
+#else
+    // every world would write CProfileManager at once
+    return false;
+#endif
+}
+
+void SweepDriver::run_variant(int index, const ci::TriMesh& mesh, 
+    ci::Vec3f scl, bool lock_base_vertices, bool pointed_up) {
+    const Variant& variant = variants_[index];
+    Result& result = results_[index];
+
+    result.variant = variant;
+    result.converged = false;
+    result.steps = 0;
+    result.kinetic_energy = 0.0f;
+    result.min = ci::Vec3f::zero();
+    result.max = ci::Vec3f::zero();
+
+    PhysicsWorld physics;
+    physics.params_ = variant.params;
+    physics.set_gravity(variant.gravity);
+    physics.weld_tolerance_ = weld_tolerance_;
+
+    btSoftBody* soft_body = physics.create_soft_mesh(mesh, scl, 
+        lock_base_vertices, pointed_up);
+
+    // nothing to simulate, the result is left unconverged with no mesh
+    if (soft_body == NULL) {
+        result.seconds = 0.0;
+        result.volume = 0.0f;
+        return;
+    }
+
+    ci::Timer timer(true);
+    float settle_time = 0.0f;
+
+    while (result.steps < max_steps_) {
+        physics.step(time_step_);
+        ++result.steps;
+
+        result.kinetic_energy = PhysicsWorld::kinetic_energy(*soft_body);
+
+        if (result.kinetic_energy > settle_energy_) {
+            settle_time = 0.0f;
+            continue;
+        }
+
+        settle_time += time_step_;
+
+        if (settle_time >= settle_time_) {
+            result.converged = true;
+            break;
+        }
+    }
+
+    timer.stop();
+    result.seconds = timer.getSeconds();
+
+    result.volume = soft_body->getVolume();
+    result.mesh = soft_body_mesh(*soft_body);
+
+    const std::vector<ci::Vec3f>& vertices = result.mesh->getVertices();
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (i == 0) {
+            result.min = vertices[i];
+            result.max = vertices[i];
+            continue;
+        }
+
+        result.min.x = ci::math<float>::min(result.min.x, vertices[i].x);
+        result.min.y = ci::math<float>::min(result.min.y, vertices[i].y);
+        result.min.z = ci::math<float>::min(result.min.z, vertices[i].z);
+        result.max.x = ci::math<float>::max(result.max.x, vertices[i].x);
+        result.max.y = ci::math<float>::max(result.max.y, vertices[i].y);
+        result.max.z = ci::math<float>::max(result.max.z, vertices[i].z);
+    }
+
+    physics.world()->removeSoftBody(soft_body);
+    delete soft_body;
+}
+
+std::tr1::shared_ptr<ci::TriMesh> SweepDriver::soft_body_mesh(
+    const btSoftBody& soft_body) {
+    std::tr1::shared_ptr<ci::TriMesh> mesh(new ci::TriMesh());
+
+    int num_nodes = soft_body.m_nodes.size();
+
+    if (num_nodes == 0)
+        return mesh;
+
+    for (int i = 0; i < num_nodes; ++i) {
+        const btVector3& x = soft_body.m_nodes[i].m_x;
+        mesh->appendVertex(ci::Vec3f(x.x(), x.y(), x.z()));
+    }
+
+    const btSoftBody::Node* base = &soft_body.m_nodes[0];
+
+    for (int i = 0; i < soft_body.m_faces.size(); ++i) {
+        const btSoftBody::Face& face = soft_body.m_faces[i];
+
+        mesh->appendTriangle((size_t) (face.m_n[0] - base), 
+            (size_t) (face.m_n[1] - base), (size_t) (face.m_n[2] - base));
+    }
+
+    return mesh;
+}
+
+std::string SweepDriver::summary() {
+    std::stringstream ss;
+
+    ss.precision(4);
+
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const Result& r = results_[i];
+
+        ss << i << ": kPR " << r.variant.params.kPR << 
+            " kDP " << r.variant.params.kDP << 
+            (r.converged ? ", settled after " : ", did not settle after ") <<
+            r.steps << " steps, " << r.seconds << " s, height " << 
+            r.max.y - r.min.y << ", volume " << r.volume << std::endl;
+    }
+
+    return ss.str();
+}
+
+}
@@ -0,0 +1,193 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include <cinder/app/App.h>
+
+#include <inc/inc_TaskPool.h>
+
+namespace inc {
+
+TaskPool::TaskPool(int num_threads) {
+    job_ = NULL;
+    begin_ = 0;
+    end_ = 0;
+    next_ = 0;
+    grain_ = 1;
+    static_chunks_ = false;
+    generation_ = 0;
+    busy_ = 0;
+    quit_ = false;
+
+    start(num_threads);
+}
+
+TaskPool::~TaskPool() {
+#ifdef TRACE_DTORS
+    ci::app::console() << "Deleting TaskPool" << std::endl;
+#endif
+
+    stop();
+}
+
+int TaskPool::hardware_threads() {
+    return std::max(1, (int) boost::thread::hardware_concurrency());
+}
+
+void TaskPool::set_num_threads(int num_threads) {
+    if (num_threads <= 0)
+        num_threads = hardware_threads();
+
+    if (num_threads == this->num_threads())
+        return;
+
+    stop();
+    start(num_threads);
+}
+
+int TaskPool::num_threads() {
+    return (int) workers_.size() + 1;
+}
+
+void TaskPool::start(int num_threads) {
+    if (num_threads <= 0)
+        num_threads = hardware_threads();
+
+    quit_ = false;
+
+    // the calling thread is thread 0
+    for (int i = 1; i < num_threads; ++i) {
+        workers_.push_back(std::tr1::shared_ptr<boost::thread>(
+            new boost::thread(&TaskPool::worker, this, i, generation_)));
+    }
+}
+
+void TaskPool::stop() {
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        quit_ = true;
+    }
+
+    work_ready_.notify_all();
+
+    std::for_each(workers_.begin(), workers_.end(),
+        [] (std::tr1::shared_ptr<boost::thread>& t) { t->join(); } );
+
+    workers_.clear();
+}
+
+void TaskPool::parallel_for(int begin, int end, 
+    const std::function<void (int)>& fn, bool static_chunks) {
+    if (end <= begin)
+        return;
+
+    if (workers_.empty() || end - begin == 1) {
+        for (int i = begin; i < end; ++i)
+            fn(i);
+
+        return;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+
+        job_ = &fn;
+        begin_ = begin;
+        end_ = end;
+        next_ = begin;
+        // batches small enough to balance, big enough that the lock 
+        // isn't taken for every index
+        grain_ = std::max(1, (end - begin) / (num_threads() * 8));
+        static_chunks_ = static_chunks;
+        busy_ = (int) workers_.size();
+        ++generation_;
+    }
+
+    work_ready_.notify_all();
+
+    run_job(0);
+
+    boost::mutex::scoped_lock lock(mutex_);
+
+    while (busy_ > 0)
+        work_done_.wait(lock);
+
+    job_ = NULL;
+}
+
+void TaskPool::worker(int id, int generation) {
+    for (;;) {
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+
+            while (!quit_ && generation_ == generation)
+                work_ready_.wait(lock);
+
+            if (quit_)
+                return;
+
+            generation = generation_;
+        }
+
+        run_job(id);
+
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+
+            if (--busy_ == 0)
+                work_done_.notify_one();
+        }
+    }
+}
+
+void TaskPool::run_job(int id) {
+    if (static_chunks_) {
+        int count = end_ - begin_;
+        int threads = num_threads();
+        int first = begin_ + (int) ((long long) count * id / threads);
+        int last = begin_ + (int) ((long long) count * (id + 1) / threads);
+
+        for (int i = first; i < last; ++i)
+            (*job_)(i);
+
+        return;
+    }
+
+    for (;;) {
+        int first;
+        int last;
+
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+
+            if (next_ >= end_)
+                return;
+
+            first = next_;
+            last = std::min(end_, next_ + grain_);
+            next_ = last;
+        }
+
+        for (int i = first; i < last; ++i)
+            (*job_)(i);
+    }
+}
+
+}
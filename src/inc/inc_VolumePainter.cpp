@@ -101,6 +101,9 @@ void VolumePainter::setup() {
     // create new bullet object from trimesh
     soft_solid_ = SolidFactory::create_soft_mesh(volume_mesh_);
 
+    if (!soft_solid_)
+        return;
+
     soft_solid_->set_flip_normals(true);
 
     Manager::instance().add_solid(soft_solid_);    
@@ -227,6 +230,9 @@ bool VolumePainter::mouse_up(ci::app::MouseEvent evt) {
     soft_solid_ = SolidFactory::create_soft_mesh(
         new_mesh);
 
+    if (!soft_solid_)
+        return false;
+
     Manager::instance().add_solid(soft_solid_);
 
     dragged_ = false;
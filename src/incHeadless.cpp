@@ -0,0 +1,346 @@
+
+/*  Copyright (c) 2010, Patrick Tierney
+*
+*  This file is part of INC (INC's Not CAD).
+*
+*  INC is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  INC is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with INC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A command line form finder with no window. Loads an OBJ or makes a dome
+// from a circular bspline, turns it into a soft mesh, steps it until it
+// settles and saves the result. For example:
+//
+//   inc_headless --obj data/tripod-3.obj --scale 15 -o tripod.dxf -o tripod.obj
+//   inc_headless --dome 40 --height 1.5 --max-steps 20000 -o dome.obj
+//
+// With --pressures and/or --dampings it runs every combination in its own
+// world instead (see SweepDriver), and variant n is saved as dome_n.obj:
+//
+//   inc_headless --dome 40 --pressures 0,50,100 --dampings 0.2,1 -o dome.obj
+//
+// The exit code is 0 if the mesh (or every variant) settled, 1 if it ran 
+// out of steps and 2 for bad arguments.
+//
+// Built by vc10/inc_headless.vcxproj only. It still links Cinder (TriMesh, 
+// ObjLoader, BSpline) as well as Bullet, and the Cinder this tree is built
+// against has no Linux port, so a Linux build for a render farm needs both
+// ported before a CMake or make target would have anything to link.
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cinder/BSpline.h>
+#include <cinder/CinderMath.h>
+#include <cinder/ObjLoader.h>
+#include <cinder/Stream.h>
+#include <cinder/Timer.h>
+#include <cinder/TriMesh.h>
+
+#include <inc/inc_Manager.h>
+#include <inc/inc_Solid.h>
+#include <inc/inc_MeshCreator.h>
+#include <inc/inc_FormFinder.h>
+#include <inc/inc_SweepDriver.h>
+
+namespace {
+
+void print_usage() {
+    std::cout << 
+        "usage: inc_headless (--obj FILE | --dome RADIUS) -o OUT [-o OUT ...]\n"
+        "  --obj FILE        mesh to inflate\n"
+        "  --dome RADIUS     make a dome from a circular bspline instead\n"
+        "  --height H        dome height multiplier (1)\n"
+        "  --resolution N    dome arch and slice resolution (50)\n"
+        "  --scale S         scale applied to the mesh (1)\n"
+        "  --free-base       don't lock the base vertices\n"
+        "  --weld TOLERANCE  merge vertices closer than this (0, exact)\n"
+        "  --cage N          simulate a cage N cells across, save the full mesh\n"
+        "  --gravity G       (1.1)\n"
+        "  --dt SECONDS      simulated time per step (1/60)\n"
+        "  --max-steps N     give up after N steps (100000)\n"
+        "  --energy E        settle threshold, kinetic energy per unit mass\n"
+        "  --dwell SECONDS   simulated time to stay under it\n"
+        "  --threads N       soft body solver threads (all), or sweep threads\n"
+        "                    (1, see SweepDriver)\n"
+        "  --pressures LIST  sweep over kPR, ie 0,50,100\n"
+        "  --dampings LIST   sweep over kDP\n"
+        "  -o OUT            .obj writes OBJ, anything else DXF\n";
+}
+
+// a closed loop of control points on a circle in the xz plane
+std::tr1::shared_ptr<ci::BSpline3f> make_circle_spline(float radius) {
+    const int num_points = 8;
+    std::vector<ci::Vec3f> points;
+
+    for (int i = 0; i < num_points; ++i) {
+        float theta = ci::lmap<float>(i, 0, num_points, 0, M_PI * 2.0f);
+
+        points.push_back(ci::Vec3f(ci::math<float>::cos(theta) * radius, 0.0f,
+            ci::math<float>::sin(theta) * radius));
+    }
+
+    // 1st = points, 2nd = degree, 3rd = add points to close, 4th = is it open
+    return std::tr1::shared_ptr<ci::BSpline3f>(new ci::BSpline3f(points, 3,
+        true, false));
+}
+
+// "0,50,100"
+std::vector<float> parse_list(const std::string& list) {
+    std::vector<float> values;
+    std::stringstream ss(list);
+    std::string item;
+
+    while (std::getline(ss, item, ','))
+        values.push_back((float) atof(item.c_str()));
+
+    return values;
+}
+
+// dome.obj -> dome_3.obj
+std::string variant_file_name(const std::string& file_name, int n) {
+    std::stringstream ss;
+    size_t dot = file_name.rfind('.');
+
+    if (dot == std::string::npos) {
+        ss << file_name << "_" << n;
+    } else {
+        ss << file_name.substr(0, dot) << "_" << n << file_name.substr(dot);
+    }
+
+    return ss.str();
+}
+
+std::tr1::shared_ptr<ci::TriMesh> load_obj(const std::string& file_name) {
+    ci::ObjLoader loader(ci::loadFileStream(file_name));
+    std::tr1::shared_ptr<ci::TriMesh> mesh(new ci::TriMesh());
+    loader.load(mesh.get(), true);
+
+    return mesh;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string obj_file;
+    float dome_radius = 0.0f;
+    float dome_height = 1.0f;
+    int resolution = 50;
+    float scale = 1.0f;
+    bool lock_base = true;
+    float gravity = 1.1f;
+    float time_step = 1.0f / 60.0f;
+    int max_steps = 100000;
+    float energy = -1.0f;
+    float dwell = -1.0f;
+    int threads = 0;
+    float weld_tolerance = 0.0f;
+    int cage_resolution = 0;
+    std::vector<float> pressures;
+    std::vector<float> dampings;
+    std::vector<std::string> outputs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--free-base") {
+            lock_base = false;
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage();
+            return 0;
+        } else if (!has_value) {
+            std::cerr << "missing value for " << arg << std::endl;
+            print_usage();
+            return 2;
+        } else if (arg == "--obj") {
+            obj_file = argv[++i];
+        } else if (arg == "--dome") {
+            dome_radius = (float) atof(argv[++i]);
+        } else if (arg == "--height") {
+            dome_height = (float) atof(argv[++i]);
+        } else if (arg == "--resolution") {
+            resolution = atoi(argv[++i]);
+        } else if (arg == "--scale") {
+            scale = (float) atof(argv[++i]);
+        } else if (arg == "--gravity") {
+            gravity = (float) atof(argv[++i]);
+        } else if (arg == "--dt") {
+            time_step = (float) atof(argv[++i]);
+        } else if (arg == "--max-steps") {
+            max_steps = atoi(argv[++i]);
+        } else if (arg == "--energy") {
+            energy = (float) atof(argv[++i]);
+        } else if (arg == "--dwell") {
+            dwell = (float) atof(argv[++i]);
+        } else if (arg == "--threads") {
+            threads = atoi(argv[++i]);
+        } else if (arg == "--weld") {
+            weld_tolerance = (float) atof(argv[++i]);
+        } else if (arg == "--cage") {
+            cage_resolution = atoi(argv[++i]);
+        } else if (arg == "--pressures") {
+            pressures = parse_list(argv[++i]);
+        } else if (arg == "--dampings") {
+            dampings = parse_list(argv[++i]);
+        } else if (arg == "-o") {
+            outputs.push_back(argv[++i]);
+        } else {
+            std::cerr << "unknown argument " << arg << std::endl;
+            print_usage();
+            return 2;
+        }
+    }
+
+    if ((obj_file.empty() && dome_radius <= 0.0f) || outputs.empty() ||
+        time_step <= 0.0f) {
+        print_usage();
+        return 2;
+    }
+
+    // the same modules as the app, minus everything that draws
+    std::tr1::shared_ptr<inc::Manager> manager(new inc::Manager());
+    std::tr1::shared_ptr<inc::SolidFactory> solid_factory(
+        new inc::SolidFactory());
+    manager->add_module(solid_factory);
+    manager->setup_modules();
+
+    inc::MeshCreator mesh_creator;
+
+    solid_factory->set_gravity(gravity);
+
+    if (threads > 0)
+        solid_factory->adjust_num_threads(threads);
+    if (energy >= 0.0f)
+        *solid_factory->settle_energy_ptr() = energy;
+    if (dwell >= 0.0f)
+        *solid_factory->settle_time_ptr() = dwell;
+
+    *solid_factory->weld_tolerance_ptr() = weld_tolerance;
+
+    if (cage_resolution > 0) {
+        *solid_factory->simulate_cage_ptr() = true;
+        *solid_factory->cage_resolution_ptr() = cage_resolution;
+    }
+
+    std::tr1::shared_ptr<ci::TriMesh> mesh;
+
+    if (!obj_file.empty()) {
+        mesh = load_obj(obj_file);
+    } else {
+        *mesh_creator.arch_resolution_ptr() = resolution;
+        *mesh_creator.slice_resolution_ptr() = resolution;
+
+        mesh = mesh_creator.generate_bspline_dome_mesh(
+            make_circle_spline(dome_radius), dome_height);
+    }
+
+    if (mesh->getNumTriangles() == 0) {
+        std::cerr << "no triangles to simulate" << std::endl;
+        return 2;
+    }
+
+    if (!pressures.empty() || !dampings.empty()) {
+        const inc::SoftBodyParams& base = solid_factory->physics().params_;
+
+        if (pressures.empty())
+            pressures.push_back(base.kPR);
+        if (dampings.empty())
+            dampings.push_back(base.kDP);
+
+        inc::SweepDriver sweep;
+        sweep.add_grid(base, gravity, pressures, dampings);
+        sweep.time_step_ = time_step;
+        sweep.max_steps_ = max_steps;
+        sweep.settle_energy_ = *solid_factory->settle_energy_ptr();
+        sweep.settle_time_ = *solid_factory->settle_time_ptr();
+        if (threads > 0)
+            sweep.num_threads_ = threads;
+        if (threads > 1 && !inc::SweepDriver::can_run_threaded())
+            std::cerr << "warning: --threads " << threads << " ignored, this" 
+                " build runs sweep variants one at a time (no BT_NO_PROFILE)"
+                << std::endl;
+        sweep.weld_tolerance_ = weld_tolerance;
+
+        std::cout << "sweeping " << sweep.num_variants() << " variants" << 
+            std::endl;
+
+        ci::Timer timer(true);
+        sweep.run(*mesh, ci::Vec3f::one() * scale, lock_base, 
+            mesh_creator.is_pointed_up());
+        timer.stop();
+
+        std::cout << sweep.summary();
+        std::cout << "sweep took " << timer.getSeconds() << " s" << std::endl;
+
+        bool all_converged = true;
+
+        for (int n = 0; n < sweep.num_variants(); ++n) {
+            const inc::SweepDriver::Result& result = sweep.results()[n];
+
+            all_converged = all_converged && result.converged;
+
+            if (!result.mesh)
+                continue;
+
+            for (size_t i = 0; i < outputs.size(); ++i)
+                inc::FormFinder::save(*result.mesh, 
+                    variant_file_name(outputs[i], n));
+        }
+
+        manager->clear_module_list();
+        solid_factory.reset();
+        manager.reset();
+
+        return all_converged ? 0 : 1;
+    }
+
+    inc::SoftSolidPtr solid = inc::SolidFactory::create_soft_mesh(mesh,
+        ci::Vec3f::one() * scale, lock_base);
+
+    if (!solid) {
+        std::cerr << "no triangles left after welding" << std::endl;
+        return 2;
+    }
+
+    manager->add_solid(solid);
+
+    std::cout << solid->soft_body().m_nodes.size() << " nodes, " <<
+        solid->soft_body().m_faces.size() << " faces" << std::endl;
+
+    inc::FormFinder finder;
+    finder.time_step_ = time_step;
+    finder.max_steps_ = max_steps;
+
+    finder.run(solid);
+
+    std::cout << finder.summary() << std::endl;
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        inc::FormFinder::save(solid, outputs[i]);
+        std::cout << "wrote " << outputs[i] << std::endl;
+    }
+
+    // same order as IncApp::shutdown, bodies before the world
+    solid.reset();
+    manager->clear_solid_list();
+    solid_factory->delete_constraints();
+    manager->clear_module_list();
+    solid_factory.reset();
+    manager.reset();
+
+    return finder.converged() ? 0 : 1;
+}